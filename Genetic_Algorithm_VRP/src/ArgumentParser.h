@@ -2,6 +2,7 @@
 
 #include <string>
 #include <algorithm>
+#include <cstdint>
 
 class ArgumentParser
 {
@@ -58,6 +59,17 @@ public:
 		return std::stoi(std::string(argv[pos + 1]), nullptr, base);
 	}
 
+	// Retrieves unsigned 64 bit int after argument
+	uint64_t GetUInt64(const std::string& shortArg = "", const std::string& longArg = "", uint64_t defaultValue = 0U, int base = 10)
+	{
+		int pos = GetPosition(shortArg, longArg);
+		if (pos == -1 || pos == argc)
+		{
+			return defaultValue;
+		}
+		return std::stoull(std::string(argv[pos + 1]), nullptr, base);
+	}
+
 	// Retrieves float after argument
 	float GetFloat(const std::string& shortArg = "", const std::string& longArg = "", float defaultValue = -1.0f)
 	{
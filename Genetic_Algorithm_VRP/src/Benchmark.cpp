@@ -0,0 +1,853 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <fstream>
+#include <map>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <omp.h>
+
+#include "Construction.h"
+#include "DistanceMatrix.h"
+#include "FactParser.h"
+#include "Genetic.h"
+#include "IslandScheduler.h"
+#include "MappedFile.h"
+#include "NeighbourIndex.h"
+#include "PathFinder.h"
+#include "Random.h"
+#include "SolomonReader.h"
+#include "Util.h"
+
+namespace
+{
+	double ElapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Random connected road network: a ring plus degree additional roads per node
+	PathFinder RandomRoadNetwork(int numNodes, int degree, uint64_t seed)
+	{
+		Xoshiro256 random;
+		random.Seed(seed);
+
+		PathFinder graph;
+		graph.Graph.resize(numNodes);
+		auto addRoad = [&](int from, int to)
+		{
+			int length = 1 + static_cast<int>(random() % 1000U);
+			graph.Graph[from].push_back(PathFinder::PII(to, length));
+			graph.Graph[to].push_back(PathFinder::PII(from, length));
+		};
+
+		for (int i = 0; i < numNodes; i++)
+		{
+			addRoad(i, (i + 1) % numNodes);
+			for (int j = 0; j < degree / 2; j++)
+			{
+				addRoad(i, static_cast<int>(random() % static_cast<uint64_t>(numNodes)));
+			}
+		}
+		return graph;
+	}
+
+	void ComparePathFinders(const std::string& name, const PathFinder& graph)
+	{
+		const int numNodes = static_cast<int>(graph.Graph.size());
+		PathFinder reference = graph;
+
+		auto start = std::chrono::steady_clock::now();
+		DistanceMatrix setDistances(numNodes);
+		for (int i = 0; i < numNodes; i++)
+		{
+			std::vector<int> dist = reference.ShortestPath(i);
+			std::copy(dist.begin(), dist.end(), setDistances[i]);
+		}
+		double setTime = ElapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		DistanceMatrix heapDistances(numNodes);
+		PathFinder::Workspace workspace;
+		for (int i = 0; i < numNodes; i++)
+		{
+			graph.ShortestPathHeap(i, workspace, heapDistances[i]);
+		}
+		double heapTime = ElapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		DistanceMatrix parallelDistances(numNodes);
+		graph.AllShortestPaths(parallelDistances);
+		double parallelTime = ElapsedMs(start);
+
+		int mismatches = 0;
+		for (int i = 0; i < numNodes; i++)
+		{
+			for (int j = 0; j < numNodes; j++)
+			{
+				if (setDistances[i][j] != heapDistances[i][j] || setDistances[i][j] != parallelDistances[i][j])
+				{
+					mismatches++;
+				}
+			}
+		}
+
+		std::cout << name << " (" << numNodes << " nodes)" << std::endl;
+		std::cout << "  std::set:        " << setTime << "ms" << std::endl;
+		std::cout << "  heap:            " << heapTime << "ms (" << setTime / heapTime << "x)" << std::endl;
+		std::cout << "  heap, " << omp_get_max_threads() << " threads: " << parallelTime << "ms (" << setTime / parallelTime << "x)" << std::endl;
+		std::cout << "  " << (mismatches == 0 ? "All distances identical" : std::to_string(mismatches) + " distances differ!") << std::endl;
+	}
+
+	// Writes numRoads random roads between numRoads / 8 cities in the format of Data/US.txt
+	void WriteRandomFacts(const std::string& path, int numRoads, uint64_t seed)
+	{
+		Xoshiro256 random;
+		random.Seed(seed);
+
+		int numCities = std::max(numRoads / 8, 100);
+		std::ofstream file(path);
+		file << "% Generated road network" << std::endl;
+		for (int i = 0; i < numRoads; i++)
+		{
+			file << "road(city" << random() % numCities << ", city" << random() % numCities << ", " << 1 + random() % 1000 << ")."
+				<< (i % 3 == 2 ? "\n" : "  ");
+		}
+		file << std::endl << "% city(name, latitude north, longitude west)" << std::endl;
+		for (int i = 0; i < numCities; i++)
+		{
+			file << "city(city" << i << ",   " << (random() % 9000) / 100.0 << ",  " << (random() % 18000) / 100.0 << "). % City " << i << std::endl;
+		}
+	}
+
+	// Parser used by ReadFile before the in-place parser, returns the sum of all road distances times city index
+	long long ParseLegacy(const std::string& path, size_t& numRoads)
+	{
+		std::vector<Road> roads;
+		std::vector<City> cities;
+		std::map<std::string, int> cityMap;
+		int cityCounter = 0;
+
+		std::ifstream file(path);
+		std::string line;
+		while (getline(file, line))
+		{
+			size_t commentIndex = line.find('%');
+			if (commentIndex == 0U)
+			{
+				continue;
+			}
+
+			if (Util::StartsWith(line, "road"))
+			{
+				size_t end = std::string::npos;
+				size_t offset = 0U;
+				while ((end = line.find('.', offset)) != std::string::npos && end < commentIndex)
+				{
+					roads.push_back(Road());
+					roads[roads.size() - 1].Parse(line.substr(offset, end));
+					offset = end + 1;
+				}
+			}
+			else if (Util::StartsWith(line, "city"))
+			{
+				size_t end = std::string::npos;
+				size_t offset = 0U;
+				while ((end = line.find(").", offset)) != std::string::npos && end < commentIndex)
+				{
+					cities.push_back(City());
+					cities[cities.size() - 1].Parse(line.substr(offset, end));
+					offset = end + 1;
+					cityMap.insert(std::make_pair(cities[cities.size() - 1].Name, cityCounter++));
+				}
+			}
+		}
+
+		long long checksum = 0;
+		for (const auto& road : roads)
+		{
+			checksum += static_cast<long long>(road.Distance) * (cityMap.at(road.City1) + 2 * cityMap.at(road.City2));
+		}
+		numRoads = roads.size();
+		return checksum;
+	}
+
+	long long ParseInPlace(const std::string& path, int maxChunks, size_t& numRoads)
+	{
+		FactParser parser;
+		if (!parser.ParseFile(path, maxChunks))
+		{
+			return -1;
+		}
+
+		long long checksum = 0;
+		for (const auto& road : parser.Roads())
+		{
+			checksum += static_cast<long long>(road.Distance) * (road.City1 + 2 * road.City2);
+		}
+		numRoads = parser.Roads().size();
+		return checksum;
+	}
+
+	// Writes a Solomon style instance: customers placed at random (R), in clusters (C) or both (RC), every time window
+	// can be reached from the depot
+	void WriteSolomon(const std::string& path, const std::string& type, int numCustomers, int capacity, uint64_t seed)
+	{
+		const int horizon = 1000;
+		const int service = 10;
+		Xoshiro256 random;
+		random.Seed(seed);
+		auto uniform = [&random](int min, int max) { return min + static_cast<int>(random() % static_cast<uint64_t>(max - min + 1)); };
+
+		std::vector<int> clusterX(8);
+		std::vector<int> clusterY(8);
+		for (size_t i = 0; i < clusterX.size(); i++)
+		{
+			clusterX[i] = uniform(10, 90);
+			clusterY[i] = uniform(10, 90);
+		}
+
+		std::ofstream file(path);
+		file << type << numCustomers << std::endl << std::endl << "VEHICLE" << std::endl << "NUMBER     CAPACITY" << std::endl
+			<< "  " << numCustomers << "         " << capacity << std::endl << std::endl << "CUSTOMER" << std::endl
+			<< "CUST NO.  XCOORD.   YCOORD.    DEMAND   READY TIME  DUE DATE   SERVICE   TIME" << std::endl << std::endl
+			<< "    0      50         50          0          0       " << horizon << "          0" << std::endl;
+
+		for (int i = 1; i <= numCustomers; i++)
+		{
+			bool clustered = type == "C" || (type == "RC" && i % 2 == 0);
+			int cluster = uniform(0, static_cast<int>(clusterX.size()) - 1);
+			int x = clustered ? clusterX[cluster] + uniform(-8, 8) : uniform(0, 100);
+			int y = clustered ? clusterY[cluster] + uniform(-8, 8) : uniform(0, 100);
+			int demand = uniform(1, 30);
+			int travel = static_cast<int>(std::ceil(std::hypot(x - 50, y - 50)));
+			int width = uniform(30, 90);
+			int ready = uniform(travel, horizon - travel - service - width);
+			file << "  " << i << "  " << x << "  " << y << "  " << demand << "  " << ready << "  " << ready + width << "  " << service << std::endl;
+		}
+	}
+
+	// Writes a CVRPLIB instance with random customers and demands around a depot in the centre
+	void WriteCvrp(const std::string& path, int numCustomers, int capacity, uint64_t seed)
+	{
+		Xoshiro256 random;
+		random.Seed(seed);
+		auto uniform = [&random](int min, int max) { return min + static_cast<int>(random() % static_cast<uint64_t>(max - min + 1)); };
+
+		std::ofstream file(path);
+		file << "NAME : random" << numCustomers + 1 << std::endl
+			<< "TYPE : CVRP" << std::endl
+			<< "DIMENSION : " << numCustomers + 1 << std::endl
+			<< "EDGE_WEIGHT_TYPE : EUC_2D" << std::endl
+			<< "CAPACITY : " << capacity << std::endl
+			<< "NODE_COORD_SECTION" << std::endl
+			<< "1 500 500" << std::endl;
+		for (int i = 2; i <= numCustomers + 1; i++)
+		{
+			file << i << " " << uniform(0, 1000) << " " << uniform(0, 1000) << std::endl;
+		}
+		file << "DEMAND_SECTION" << std::endl << "1 0" << std::endl;
+		for (int i = 2; i <= numCustomers + 1; i++)
+		{
+			file << i << " " << uniform(1, 30) << std::endl;
+		}
+		file << "DEPOT_SECTION" << std::endl << " 1" << std::endl << " -1" << std::endl << "EOF" << std::endl;
+	}
+
+	// Runs the solver for a fixed number of generations, returns generations per second
+	double GenerationsPerSecond(GeneticAlgorithm& algorithm, int generations, int& bestFitness)
+	{
+		algorithm.SetSeed(42U, 0);
+		algorithm.mIterations = generations;
+		auto start = std::chrono::steady_clock::now();
+		algorithm.SolveVRP();
+		double time = ElapsedMs(start);
+		bestFitness = algorithm.GetBestFitness();
+		return algorithm.GetGenerations() / time * 1000.0;
+	}
+
+	// Number of cities whose neighbours differ from the k first of a full sort by distance and id
+	int CountNeighbourErrors(const DistanceOracle& distances, const NeighbourIndex& index, int k)
+	{
+		int errors = 0;
+		std::vector<std::pair<int, int>> row;
+		for (int i = 0; i < distances.Size(); i++)
+		{
+			row.clear();
+			for (int j = 0; j < distances.Size(); j++)
+			{
+				if (j != i)
+				{
+					row.push_back(std::make_pair(distances(i, j), j));
+				}
+			}
+			std::sort(row.begin(), row.end());
+			int count = std::min(k, static_cast<int>(row.size()));
+			bool equal = index.Count(i) == count;
+			for (int n = 0; equal && n < count; n++)
+			{
+				equal = static_cast<int>(index.Begin(i)[n]) == row[n].second;
+			}
+			errors += equal ? 0 : 1;
+		}
+		return errors;
+	}
+
+	// Evaluates a random population with EvaluateFitness, the scalar kernel and the batch kernel
+	void CompareFitnessEvaluation(const std::string& path, const std::string& name)
+	{
+		GeneticAlgorithm algorithm;
+		algorithm.mUseDistanceCache = false;
+		if (!algorithm.ReadFile(path, true) || !algorithm.mDistances->IsMatrix())
+		{
+			return;
+		}
+		const int size = 1000;
+		algorithm.mPopulationSize = size;
+		Population population;
+		population.Resize(size, algorithm.mRouteSize, algorithm.EvaluationCacheSize());
+		algorithm.SetSeed(42U, 0);
+		algorithm.InitPopulation(population);
+
+		// About 2 * 10^7 chromosome positions per version
+		const int rounds = std::max(1, 20000000 / (size * algorithm.mRouteSize));
+		std::cout << name << " (" << algorithm.mNumCities << " cities, " << algorithm.GetVehicles() << " vehicles, "
+			<< size << " individuals, " << rounds << " rounds)" << std::endl;
+
+		std::vector<int> reference(size);
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				reference[i] = algorithm.EvaluateFitness(population[i]);
+			}
+		}
+		const double referenceRate = size * static_cast<double>(rounds) / ElapsedMs(start) * 1000.0;
+		std::cout << "  EvaluateFitness: " << referenceRate << " individuals/s" << std::endl;
+
+		std::vector<int> scalarCache;
+		for (bool batch : { false, true })
+		{
+			algorithm.mBatchEvaluation = batch;
+			start = std::chrono::steady_clock::now();
+			for (int round = 0; round < rounds; round++)
+			{
+				for (int i = 0; i < size; i++)
+				{
+					population.SetDirty(i, true);
+				}
+				algorithm.EvaluatePopulation(population);
+			}
+			const double rate = size * static_cast<double>(rounds) / ElapsedMs(start) * 1000.0;
+
+			int differences = 0;
+			std::vector<int> cache;
+			for (int i = 0; i < size; i++)
+			{
+				differences += population.Fitness()[i] == reference[i] ? 0 : 1;
+				cache.insert(cache.end(), population.Cache(i), population.Cache(i) + algorithm.EvaluationCacheSize());
+			}
+			if (!batch)
+			{
+				scalarCache = cache;
+			}
+			std::cout << "  " << (batch ? "batch kernel:    " : "scalar kernel:   ") << rate << " individuals/s ("
+				<< rate / referenceRate << "x), " << (differences == 0 ? "bit-identical" : std::to_string(differences) + " results differ!")
+				<< (batch && cache != scalarCache ? ", caches differ!" : "") << std::endl;
+		}
+	}
+
+	void CompareTimeWindowEvaluation(const std::string& path, const std::string& name, int generations)
+	{
+		GeneticAlgorithm algorithm;
+		algorithm.mUseDistanceCache = false;
+		if (!algorithm.ReadFile(path, true) || algorithm.mTimeWindows.empty())
+		{
+			return;
+		}
+
+		// Enough vehicles for the total demand plus some slack for the time windows
+		int totalDemand = 0;
+		for (int demand : algorithm.mDemands)
+		{
+			totalDemand += demand;
+		}
+		int vehicles = algorithm.mCapacity > 0 ? (totalDemand + algorithm.mCapacity - 1) / algorithm.mCapacity + 2 : 10;
+		algorithm.SetVehicles(std::min(std::max(vehicles, 2), algorithm.mNumCities - 1));
+		std::cout << name << " (" << algorithm.mNumCities - 1 << " customers, " << algorithm.GetVehicles() << " vehicles, " << generations << " generations)" << std::endl;
+
+		int fullFitness = 0;
+		algorithm.mDeltaEvaluation = false;
+		double full = GenerationsPerSecond(algorithm, generations, fullFitness);
+		std::cout << "  full evaluation:      " << full << " generations/s" << std::endl;
+
+		int deltaFitness = 0;
+		algorithm.mDeltaEvaluation = true;
+		double delta = GenerationsPerSecond(algorithm, generations, deltaFitness);
+		std::cout << "  delta evaluation:     " << delta << " generations/s (" << delta / full << "x)"
+			<< (deltaFitness == fullFitness ? "" : ", results differ!") << std::endl;
+
+		// The mutation step alone: every individual gets a swap and is evaluated again
+		algorithm.SetSeed(42U, 0);
+		const double mutationRate = algorithm.mMutationRate;
+		algorithm.mMutationRate = 1.0;
+		Population initial;
+		initial.Resize(algorithm.mPopulationSize, algorithm.mRouteSize, algorithm.EvaluationCacheSize());
+		algorithm.InitPopulation(initial);
+		algorithm.mDeltaEvaluation = true;	// Builds the time segments, the full evaluation ignores them
+		algorithm.EvaluatePopulation(initial);
+		const int rounds = 200;
+		double swapRates[2] = {};
+		std::vector<int> swapFitness[2];
+		for (int delta = 0; delta < 2; delta++)
+		{
+			algorithm.mDeltaEvaluation = delta == 1;
+			algorithm.SetSeed(7U, 0);
+			Population population;
+			population.Resize(algorithm.mPopulationSize, algorithm.mRouteSize, algorithm.EvaluationCacheSize());
+			for (int i = 0; i < algorithm.mPopulationSize; i++)
+			{
+				population.CopyRow(initial, i, i);
+			}
+			auto start = std::chrono::steady_clock::now();
+			for (int round = 0; round < rounds; round++)
+			{
+				algorithm.Mutate(population);
+				algorithm.EvaluatePopulation(population);
+			}
+			swapRates[delta] = algorithm.mPopulationSize * static_cast<double>(rounds) / ElapsedMs(start) * 1000.0;
+			swapFitness[delta].assign(population.Fitness(), population.Fitness() + algorithm.mPopulationSize);
+		}
+		algorithm.mMutationRate = mutationRate;
+		std::cout << "  swap, full evaluation: " << swapRates[0] << " individuals/s" << std::endl;
+		std::cout << "  swap, delta:           " << swapRates[1] << " individuals/s (" << swapRates[1] / swapRates[0] << "x)"
+			<< (swapFitness[0] == swapFitness[1] ? "" : ", results differ!") << std::endl;
+
+		int baselineFitness = 0;
+		algorithm.mTimeWindows.clear();
+		double baseline = GenerationsPerSecond(algorithm, generations, baselineFitness);
+		std::cout << "  without time windows: " << baseline << " generations/s" << std::endl;
+	}
+}
+
+bool Benchmark::Run(const std::string& name, const std::string& inputFile, int size)
+{
+	if (name == "pathfinder")
+	{
+		ShortestPaths(inputFile, size > 0 ? size : 2000);
+		return true;
+	}
+	if (name == "parser")
+	{
+		Parser(size > 0 ? size : 500000);
+		return true;
+	}
+	if (name == "vrptw")
+	{
+		TimeWindows(inputFile, size > 0 ? size : 100);
+		return true;
+	}
+	if (name == "neighbours")
+	{
+		Neighbours(size, 10);
+		return true;
+	}
+	if (name == "fitness")
+	{
+		Fitness(inputFile, size);
+		return true;
+	}
+	if (name == "island-threads")
+	{
+		IslandThreads(inputFile, size > 0 ? size : 100000);
+		return true;
+	}
+	if (name == "islands")
+	{
+		Islands(inputFile, size > 0 ? size : 64);
+		return true;
+	}
+	if (name == "construction")
+	{
+		ConstructionHeuristics(inputFile, size > 0 ? size : 1000);
+		return true;
+	}
+	std::cout << "Unknown benchmark " << name << std::endl;
+	return false;
+}
+
+void Benchmark::ShortestPaths(const std::string& inputFile, int numNodes)
+{
+	// Roads of the input file without calculated routes
+	GeneticAlgorithm input;
+	input.mUseDistanceCache = false;
+	if (input.ReadFile(inputFile, false) && input.mNumCities > 0)
+	{
+		const DistanceOracle& distances = *input.mDistances;
+		PathFinder graph;
+		for (int i = 0; i < input.mNumCities; i++)
+		{
+			PathFinder::VPII a;
+			for (int j = 0; j < input.mNumCities; j++)
+			{
+				if (distances(i, j) != 0 && distances(i, j) != -1)
+				{
+					a.push_back(PathFinder::PII(j, distances(i, j)));
+				}
+			}
+			graph.Graph.push_back(a);
+		}
+		ComparePathFinders(inputFile, graph);
+	}
+
+	ComparePathFinders("Random road network", RandomRoadNetwork(numNodes, 6, 42U));
+}
+
+void Benchmark::Parser(int numRoads)
+{
+	const std::string path = "parser_benchmark.tmp";
+	WriteRandomFacts(path, numRoads, 42U);
+
+	MappedFile file;
+	file.Open(path);
+	double megabytes = file.Size() / (1024.0 * 1024.0);
+	file.Close();
+	std::cout << "Random road network (" << numRoads << " roads, " << megabytes << " MB)" << std::endl;
+
+	size_t legacyRoads = 0U;
+	auto start = std::chrono::steady_clock::now();
+	long long legacy = ParseLegacy(path, legacyRoads);
+	double legacyTime = ElapsedMs(start);
+	std::cout << "  getline/std::map: " << legacyTime << "ms, " << megabytes / legacyTime * 1000.0 << " MB/s" << std::endl;
+
+	int threads[] = { 1, omp_get_max_threads() };
+	for (int maxChunks : threads)
+	{
+		size_t roads = 0U;
+		start = std::chrono::steady_clock::now();
+		long long checksum = ParseInPlace(path, maxChunks, roads);
+		double time = ElapsedMs(start);
+		std::cout << "  in place, " << maxChunks << " threads: " << time << "ms, " << megabytes / time * 1000.0 << " MB/s ("
+			<< legacyTime / time << "x)" << (checksum == legacy && roads == legacyRoads ? "" : ", results differ!") << std::endl;
+	}
+
+	std::remove(path.c_str());
+}
+
+void Benchmark::TimeWindows(const std::string& inputFile, int numCustomers)
+{
+	const int generations = 1000;
+
+	MappedFile input;
+	if (input.Open(inputFile) && SolomonReader().CanRead(std::string_view(input.Data(), std::min<size_t>(input.Size(), 4096U))))
+	{
+		CompareTimeWindowEvaluation(inputFile, inputFile, generations);
+	}
+
+	const std::string path = "vrptw_benchmark.tmp";
+	std::string types[] = { "R", "C", "RC" };
+	for (const std::string& type : types)
+	{
+		WriteSolomon(path, type, numCustomers, 200, 42U);
+		CompareTimeWindowEvaluation(path, type + std::to_string(numCustomers), generations);
+	}
+	std::remove(path.c_str());
+}
+
+void Benchmark::Neighbours(int numCities, int k)
+{
+	std::vector<int> sizes = { 1000, 10000, 100000 };
+	if (numCities > 0)
+	{
+		sizes.assign(1, numCities);
+	}
+
+	for (int size : sizes)
+	{
+		Xoshiro256 random;
+		random.Seed(42U);
+		std::vector<double> x(size);
+		std::vector<double> y(size);
+		for (int i = 0; i < size; i++)
+		{
+			x[i] = static_cast<double>(random() % 1000000U);
+			y[i] = static_cast<double>(random() % 1000000U);
+		}
+		DistanceOracle distances(DistanceOracle::Metric::Euclidean, x, y);
+
+		auto start = std::chrono::steady_clock::now();
+		NeighbourIndex index;
+		index.Build(distances, k, NeighbourIndex::Direction::Outgoing);
+		double time = ElapsedMs(start);
+		double megabytes = (index.Offsets().size() + index.Ids().size()) * sizeof(uint32_t) / (1024.0 * 1024.0);
+
+		std::cout << size << " cities, k = " << k << ": " << time << "ms with " << omp_get_max_threads() << " threads, "
+			<< megabytes << " MB";
+		if (size <= 10000)
+		{
+			int errors = CountNeighbourErrors(distances, index, k);
+			std::cout << (errors == 0 ? ", same as full sort" : ", " + std::to_string(errors) + " rows differ from full sort!");
+		}
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::ConstructionHeuristics(const std::string& inputFile, int count)
+{
+	GeneticAlgorithm algorithm;
+	algorithm.mUseDistanceCache = false;
+	algorithm.mHeuristicFraction = 1.0;	// The heuristics take their candidates from the neighbour index
+	if (!algorithm.ReadFile(inputFile, true))
+	{
+		return;
+	}
+	algorithm.mPopulationSize = count;
+	std::cout << inputFile << " (" << algorithm.mNumCities << " cities, " << algorithm.GetVehicles() << " vehicles), "
+		<< count << " individuals per method, " << omp_get_max_threads() << " threads" << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	Construction construction;
+	construction.Setup(algorithm);
+	std::cout << "  setup (savings list, sweep order): " << ElapsedMs(start) << "ms" << std::endl;
+
+	struct Result
+	{
+		std::string Name;
+		double Time;
+		double Mean;
+		int Best;
+	};
+	std::vector<Result> results;
+	Population population;
+	population.Resize(count, algorithm.mRouteSize);
+	auto evaluate = [&](const std::string& name, double time)
+	{
+		double sum = 0.0;
+		int best = INT32_MAX;
+		for (int i = 0; i < count; i++)
+		{
+			int fitness = algorithm.EvaluateFitness(population[i]);
+			sum += fitness;
+			best = std::min(best, fitness);
+		}
+		results.push_back(Result{ name, time, sum / count, best });
+	};
+
+	algorithm.SetSeed(42U, 0);
+	start = std::chrono::steady_clock::now();
+	algorithm.InitPopulation(population);
+	evaluate("random", ElapsedMs(start));
+
+	// One random stream per individual, like SeedPopulation
+	std::vector<uint64_t> seeds(count);
+	Xoshiro256 seeder(42U);
+	for (uint64_t& seed : seeds)
+	{
+		seed = seeder();
+	}
+	for (int method = 0; method < Construction::sNumMethods; method++)
+	{
+		start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < count; i++)
+		{
+			Xoshiro256 random(seeds[i]);
+			construction.Build(static_cast<Construction::Method>(method), random, population[i]);
+		}
+		evaluate(Construction::MethodName(static_cast<Construction::Method>(method)), ElapsedMs(start));
+	}
+
+	int best = INT32_MAX;
+	for (const Result& result : results)
+	{
+		best = std::min(best, result.Best);
+	}
+	for (const Result& result : results)
+	{
+		std::cout << "  " << result.Name << ": " << result.Time << "ms, mean fitness " << result.Mean << ", best " << result.Best
+			<< ", gap of the mean " << (result.Mean - best) / best * 100.0 << "%" << std::endl;
+	}
+	if (!construction.HasCoordinates())
+	{
+		std::cout << "  (no coordinates, sweep uses nearest neighbour)" << std::endl;
+	}
+}
+
+void Benchmark::Fitness(const std::string& inputFile, int numCities)
+{
+	std::vector<int> sizes = { 100, 1000, 5000 };
+	if (numCities > 0)
+	{
+		sizes.assign(1, numCities);
+	}
+
+	CompareFitnessEvaluation(inputFile, inputFile);
+	const std::string path = "benchmark_fitness.vrp";
+	for (int size : sizes)
+	{
+		WriteCvrp(path, size, 100, 42U);
+		CompareFitnessEvaluation(path, "Random CVRP with " + std::to_string(size) + " customers");
+	}
+	std::remove(path.c_str());
+}
+
+void Benchmark::IslandThreads(const std::string& inputFile, int populationSize)
+{
+	const int generations = 10;
+
+	GeneticAlgorithm algorithm;
+	algorithm.mUseDistanceCache = false;
+	if (!algorithm.ReadFile(inputFile, true))
+	{
+		return;
+	}
+	algorithm.mPopulationSize = populationSize;
+	std::cout << inputFile << " (" << algorithm.mNumCities << " cities, " << populationSize << " individuals, "
+		<< generations << " generations)" << std::endl;
+
+	// At least two threads, so the parallel path is measured and checked on a single core as well
+	const int maxThreads = std::max(omp_get_max_threads(), 2);
+	double sequential = 0.0;
+	int sequentialFitness = 0;
+	for (int threads = 1; threads <= maxThreads; threads = (threads * 2 > maxThreads && threads != maxThreads) ? maxThreads : threads * 2)
+	{
+		algorithm.mIslandThreads = threads;
+		int fitness = 0;
+		double rate = GenerationsPerSecond(algorithm, generations, fitness);
+		if (threads == 1)
+		{
+			sequential = rate;
+			sequentialFitness = fitness;
+			std::cout << "  1 thread:   " << rate << " generations/s" << std::endl;
+			continue;
+		}
+		std::cout << "  " << threads << " threads: " << (threads < 10 ? " " : "") << rate << " generations/s (" << rate / sequential << "x)"
+			<< (fitness == sequentialFitness ? "" : ", results differ!") << std::endl;
+	}
+}
+
+void Benchmark::Islands(const std::string& inputFile, int numIslands)
+{
+	const int generations = 100;
+	const int threads = omp_get_max_threads();
+
+	GeneticAlgorithm prototype;
+	prototype.mUseDistanceCache = false;
+	if (!prototype.ReadFile(inputFile, true))
+	{
+		return;
+	}
+	prototype.mIterations = generations;
+	std::cout << inputFile << " (" << prototype.mNumCities << " cities), " << numIslands << " islands with 100 to 800 individuals, "
+		<< generations << " generations, " << threads << " threads" << std::endl;
+
+	// Islands of different cost, same seeds for both runs
+	auto createIslands = [&](int count, int firstStream)
+	{
+		std::vector<std::unique_ptr<GeneticAlgorithm>> islands;
+		for (int i = 0; i < count; i++)
+		{
+			islands.push_back(std::make_unique<GeneticAlgorithm>(prototype));
+			islands.back()->mPopulationSize = 100 * (1 + (firstStream + i) % 8);
+			islands.back()->SetSeed(42U, firstStream + i);
+		}
+		return islands;
+	};
+	auto islandGenerations = [](const std::vector<std::unique_ptr<GeneticAlgorithm>>& islands, int begin, int end)
+	{
+		long long sum = 0;
+		for (int i = begin; i < end; i++)
+		{
+			sum += islands[i]->GetGenerations();
+		}
+		return sum;
+	};
+
+	// One island per loop iteration, the islands are split into equal blocks up front
+	std::vector<std::unique_ptr<GeneticAlgorithm>> loop = createIslands(numIslands, 0);
+	auto start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < numIslands; i++)
+	{
+		loop[i]->SolveVRP();
+	}
+	double loopTime = ElapsedMs(start);
+	std::cout << "  static loop: " << loopTime << "ms, " << islandGenerations(loop, 0, numIslands) / loopTime * 1000.0
+		<< " island generations/s" << std::endl;
+
+	std::vector<std::unique_ptr<GeneticAlgorithm>> tasks = createIslands(numIslands, 0);
+	bool same = true;
+	double taskTime = 0.0;
+	start = std::chrono::steady_clock::now();
+	{
+		IslandScheduler scheduler(threads, 10);
+		for (auto& island : tasks)
+		{
+			scheduler.Spawn(island.get());
+		}
+		scheduler.Wait();
+		double time = ElapsedMs(start);
+		taskTime = time;
+		for (int i = 0; i < numIslands; i++)
+		{
+			same = same && tasks[i]->GetBestFitness() == loop[i]->GetBestFitness();
+		}
+		std::cout << "  scheduler:   " << time << "ms, " << islandGenerations(tasks, 0, numIslands) / time * 1000.0
+			<< " island generations/s (" << loopTime / time << "x), " << scheduler.Slices() << " slices, " << scheduler.Steals()
+			<< " steals" << (same ? "" : ", results differ!") << std::endl;
+	}
+
+	// Even islands are paused and later resumed, odd ones are killed and a quarter more is spawned in between.
+	// The steps are a tenth of the scheduler run apart
+	std::vector<std::unique_ptr<GeneticAlgorithm>> control = createIslands(numIslands + numIslands / 4, 0);
+	const auto step = std::chrono::microseconds(static_cast<long long>(taskTime * 100.0) + 1);
+	start = std::chrono::steady_clock::now();
+	IslandScheduler scheduler(threads, 10);
+	for (int i = 0; i < numIslands; i++)
+	{
+		scheduler.Spawn(control[i].get());
+	}
+	std::this_thread::sleep_for(step);
+	for (int i = 0; i < numIslands; i += 2)
+	{
+		scheduler.Pause(i);
+	}
+	std::this_thread::sleep_for(step);
+	for (int i = 1; i < numIslands; i += 2)
+	{
+		scheduler.Kill(i);
+	}
+	for (int i = numIslands; i < static_cast<int>(control.size()); i++)
+	{
+		scheduler.Spawn(control[i].get());
+	}
+	std::this_thread::sleep_for(step);
+	for (int i = 0; i < numIslands; i += 2)
+	{
+		scheduler.Resume(i);
+	}
+	scheduler.Wait();
+	double time = ElapsedMs(start);
+
+	int killed = 0;
+	int finished = 0;
+	for (int i = 0; i < static_cast<int>(control.size()); i++)
+	{
+		if (i < numIslands && i % 2 == 1)
+		{
+			killed += control[i]->GetGenerations() < control[i]->mIterations ? 1 : 0;
+		}
+		else
+		{
+			finished += control[i]->GetGenerations() == control[i]->mIterations ? 1 : 0;
+		}
+	}
+	std::cout << "  pause, kill, spawn, resume: " << time << "ms, " << killed << " of " << numIslands / 2 << " killed islands stopped early, "
+		<< finished << " of " << control.size() - numIslands / 2 << " paused and spawned islands finished" << std::endl;
+}
\ No newline at end of file
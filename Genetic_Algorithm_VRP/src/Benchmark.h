@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+
+// Micro-benchmarks that can be started from the command line with --benchmark <name>
+namespace Benchmark
+{
+	// Runs the benchmark with the given name, returns false if there is none
+	bool Run(const std::string& name, const std::string& inputFile, int size);
+
+	// All-pairs shortest paths: std::set Dijkstra vs indexed binary heap, sequential and parallel.
+	// Uses the roads of inputFile and a random road network with numNodes nodes
+	void ShortestPaths(const std::string& inputFile, int numNodes);
+
+	// Parse throughput in MB/s: getline/substr/std::map parser vs in-place parser with one and all threads.
+	// Uses a generated file with numRoads roads
+	void Parser(int numRoads);
+
+	// Generations per second of the solver on VRPTW instances in Solomon format with random, clustered and mixed
+	// customers: swap mutations evaluated by delta (prefix and suffix time segments) vs. a full evaluation of every mutated
+	// individual, for whole generations and for the mutation step alone, and the solver without time windows as
+	// baseline. inputFile is added if it is a Solomon instance
+	void TimeWindows(const std::string& inputFile, int numCustomers);
+
+	// Build time and size of the k nearest neighbour index for 1k, 10k and 100k random cities (or numCities) with
+	// Euclidean distances computed on demand, checked against a full sort of every row for the small sizes
+	void Neighbours(int numCities, int k);
+
+	// Time and initial quality of the construction heuristics on inputFile: count individuals per method, built in
+	// parallel, and random individuals as baseline. Prints mean and best fitness and the gap of the mean to the best
+	// individual of all methods
+	void ConstructionHeuristics(const std::string& inputFile, int count);
+
+	// Individuals per second of the fitness evaluation on inputFile and random CVRP instances with 100, 1k and 5k
+	// customers (or numCities): the scalar EvaluateFitness, the scalar fleet size kernel and the batch kernel with
+	// gathers. Both kernels are checked to be bit-identical to EvaluateFitness
+	void Fitness(const std::string& inputFile, int numCities);
+
+	// Generations per second of one island with populationSize individuals on inputFile, bred, mutated and evaluated
+	// by 1, 2, 4, ... island threads. All runs are checked to find the same solution
+	void IslandThreads(const std::string& inputFile, int populationSize);
+
+	// Islands on the work-stealing IslandScheduler with all threads: numIslands islands on inputFile with population
+	// sizes of 100 to 800, solved by a static OpenMP loop over the islands and by the scheduler (same results expected),
+	// then a run in which islands are paused, killed, spawned and resumed while the others run
+	void Islands(const std::string& inputFile, int numIslands);
+}
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <omp.h>
+
+#include "Construction.h"
+#include "Genetic.h"
+#include "Profiler.h"
+#include "Split.h"
+
+const double Construction::sSkipRate = 0.1;
+
+namespace
+{
+	// Sorts one chunk per thread and merges neighbouring chunks in rounds, every round in parallel.
+	// compare has to be a total order, then the result does not depend on the number of threads
+	template<typename T, typename Compare>
+	void ParallelSort(std::vector<T>& values, Compare compare)
+	{
+		const int chunks = std::max(1, std::min(omp_get_max_threads(), static_cast<int>(values.size() / 4096U)));
+		std::vector<size_t> bounds(chunks + 1);
+		for (int c = 0; c <= chunks; c++)
+		{
+			bounds[c] = values.size() * static_cast<size_t>(c) / static_cast<size_t>(chunks);
+		}
+
+#pragma omp parallel for
+		for (int c = 0; c < chunks; c++)
+		{
+			std::sort(values.begin() + bounds[c], values.begin() + bounds[c + 1], compare);
+		}
+		for (int width = 1; width < chunks; width *= 2)
+		{
+#pragma omp parallel for
+			for (int c = 0; c < chunks - width; c += 2 * width)
+			{
+				std::inplace_merge(values.begin() + bounds[c], values.begin() + bounds[c + width],
+					values.begin() + bounds[std::min(c + 2 * width, chunks)], compare);
+			}
+		}
+	}
+}
+
+Construction::Construction()
+	: mGa(nullptr)
+	, mDistances(nullptr)
+	, mNeighbours(nullptr)
+	, mDemands(nullptr)
+	, mCapacity(0)
+	, mDepot(0)
+{
+}
+
+void Construction::Setup(const GeneticAlgorithm& ga)
+{
+	PROFILE_SCOPE("Construction");
+	const int numCities = ga.mNumCities;
+	const std::vector<City>& cities = ga.mCities;
+	mGa = &ga;
+	mDistances = ga.mDistances.get();
+	mNeighbours = ga.mNeighbourIndex.get();
+	mDemands = ga.mDemands.empty() ? nullptr : ga.mDemands.data();
+	mCapacity = mDemands != nullptr ? ga.mCapacity : 0;
+
+	// Matrix inputs have no coordinates
+	const bool hasCoordinates = std::any_of(cities.begin(), cities.end(), [](const City& city) { return city.X != 0.0f || city.Y != 0.0f; });
+
+	// An evolved depot starts at the city next to the centre
+	mDepot = ga.mDepot;
+	if (mDepot < 0)
+	{
+		mDepot = 0;
+		if (hasCoordinates)
+		{
+			double x = 0.0;
+			double y = 0.0;
+			for (const City& city : cities)
+			{
+				x += city.X;
+				y += city.Y;
+			}
+			x /= numCities;
+			y /= numCities;
+			double best = -1.0;
+			for (int i = 0; i < numCities; i++)
+			{
+				double distance = std::hypot(cities[i].X - x, cities[i].Y - y);
+				if (best < 0.0 || distance < best)
+				{
+					best = distance;
+					mDepot = i;
+				}
+			}
+		}
+	}
+
+	mCustomers.clear();
+	for (int i = 0; i < numCities; i++)
+	{
+		if (i != mDepot)
+		{
+			mCustomers.push_back(i);
+		}
+	}
+
+	mSweepOrder.clear();
+	if (hasCoordinates)
+	{
+		std::vector<double> angles(numCities);
+		for (int city : mCustomers)
+		{
+			angles[city] = std::atan2(cities[city].Y - cities[mDepot].Y, cities[city].X - cities[mDepot].X);
+		}
+		mSweepOrder = mCustomers;
+		std::sort(mSweepOrder.begin(), mSweepOrder.end(), [&angles](int a, int b) { return angles[a] < angles[b] || (angles[a] == angles[b] && a < b); });
+	}
+
+	// Savings of every customer and its neighbours (all customers without index), missing roads have none
+	const DistanceOracle& distances = *mDistances;
+	mSavings.clear();
+	for (int from : mCustomers)
+	{
+		const int toDepot = distances(from, mDepot);
+		auto add = [&](int to)
+		{
+			if (to == from || to == mDepot || toDepot < 0)
+			{
+				return;
+			}
+			const int fromDepot = distances(mDepot, to);
+			const int direct = distances(from, to);
+			if (fromDepot >= 0 && direct >= 0 && toDepot + fromDepot - direct > 0)
+			{
+				mSavings.push_back(Saving{ toDepot + fromDepot - direct, from, to });
+			}
+		};
+		if (mNeighbours != nullptr)
+		{
+			for (const uint32_t* n = mNeighbours->Begin(from); n != mNeighbours->End(from); ++n)
+			{
+				add(static_cast<int>(*n));
+			}
+		}
+		else
+		{
+			for (int to : mCustomers)
+			{
+				add(to);
+			}
+		}
+	}
+	ParallelSort(mSavings, [](const Saving& a, const Saving& b)
+	{
+		if (a.Value != b.Value)
+		{
+			return a.Value > b.Value;
+		}
+		return a.From < b.From || (a.From == b.From && a.To < b.To);
+	});
+}
+
+void Construction::Build(Method method, Xoshiro256& random, int* individual) const
+{
+	switch (method)
+	{
+	case Method::NearestNeighbour:
+		NearestNeighbour(random, individual);
+		break;
+	case Method::Savings:
+		Savings(random, individual);
+		break;
+	case Method::Sweep:
+		if (HasCoordinates())
+		{
+			Sweep(random, individual);
+		}
+		else
+		{
+			NearestNeighbour(random, individual);
+		}
+		break;
+	}
+}
+
+const char* Construction::MethodName(Method method)
+{
+	switch (method)
+	{
+	case Method::NearestNeighbour: return "nearest neighbour";
+	case Method::Savings: return "savings";
+	case Method::Sweep: return "sweep";
+	}
+	return "";
+}
+
+void Construction::NearestNeighbour(Xoshiro256& random, int* individual) const
+{
+	static thread_local std::vector<char> visited;
+	static thread_local std::vector<int> tour;
+	const DistanceOracle& distances = *mDistances;
+	visited.assign(mGa->mNumCities, 0);
+	visited[mDepot] = 1;
+	tour.clear();
+
+	int current = mDepot;
+	int candidates[sCandidates];
+	for (size_t step = 0; step < mCustomers.size(); step++)
+	{
+		// Nearest unvisited cities out of the neighbour list, all cities are scanned once it is used up.
+		// A missing road (-1) counts as the longest distance
+		int count = 0;
+		if (mNeighbours != nullptr)
+		{
+			for (const uint32_t* n = mNeighbours->Begin(current); n != mNeighbours->End(current) && count < sCandidates; ++n)
+			{
+				if (!visited[*n])
+				{
+					candidates[count++] = static_cast<int>(*n);
+				}
+			}
+		}
+		if (count == 0)
+		{
+			unsigned int lengths[sCandidates];
+			for (int city : mCustomers)
+			{
+				if (visited[city])
+				{
+					continue;
+				}
+				const unsigned int length = static_cast<unsigned int>(distances(current, city));
+				int k = count < sCandidates ? count++ : sCandidates;
+				for (; k > 0 && lengths[k - 1] > length; k--)
+				{
+					if (k < sCandidates)
+					{
+						lengths[k] = lengths[k - 1];
+						candidates[k] = candidates[k - 1];
+					}
+				}
+				if (k < sCandidates)
+				{
+					lengths[k] = length;
+					candidates[k] = city;
+				}
+			}
+		}
+
+		std::uniform_int_distribution<int> distribution(0, count - 1);
+		current = candidates[distribution(random)];
+		visited[current] = 1;
+		tour.push_back(current);
+	}
+	SplitTour(tour, individual);
+}
+
+void Construction::Savings(Xoshiro256& random, int* individual) const
+{
+	static thread_local std::vector<int> next;
+	static thread_local std::vector<int> previous;
+	static thread_local std::vector<int> other;
+	static thread_local std::vector<int> load;
+	const int numCities = mGa->mNumCities;
+	const int vehicles = mGa->GetVehicles();
+
+	// Every customer starts with its own route, both ends of a route know the other end and the load of the route
+	next.assign(numCities, -1);
+	previous.assign(numCities, -1);
+	other.resize(numCities);
+	load.resize(numCities);
+	for (int city : mCustomers)
+	{
+		other[city] = city;
+		load[city] = mDemands != nullptr ? mDemands[city] : 0;
+	}
+	int routes = static_cast<int>(mCustomers.size());
+
+	// Appends the route that starts with to to the route that ends with from
+	auto join = [&](int from, int to)
+	{
+		const int first = other[from];
+		const int last = other[to];
+		const int total = load[from] + load[to];
+		next[from] = to;
+		previous[to] = from;
+		other[first] = last;
+		other[last] = first;
+		load[first] = total;
+		load[last] = total;
+		routes--;
+	};
+
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	for (const Saving& saving : mSavings)
+	{
+		if (routes == vehicles)
+		{
+			break;
+		}
+		// From has to end and to has to start a different route
+		if (next[saving.From] != -1 || previous[saving.To] != -1 || other[saving.From] == saving.To)
+		{
+			continue;
+		}
+		if (mCapacity > 0 && load[saving.From] + load[saving.To] > mCapacity)
+		{
+			continue;
+		}
+		if (chance(random) < sSkipRate)
+		{
+			continue;
+		}
+		join(saving.From, saving.To);
+	}
+
+	// Too many routes left: the two lightest ones are joined until the fleet size is reached, over the capacity if needed
+	if (routes > vehicles)
+	{
+		using Entry = std::pair<int, int>;	// Load and first customer of a route
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> lightest;
+		for (int city : mCustomers)
+		{
+			if (previous[city] == -1)
+			{
+				lightest.push(Entry(load[city], city));
+			}
+		}
+		while (routes > vehicles)
+		{
+			const int first = lightest.top().second;
+			lightest.pop();
+			const int second = lightest.top().second;
+			lightest.pop();
+			join(other[first], second);
+			lightest.push(Entry(load[first], first));
+		}
+	}
+
+	int position = 0;
+	individual[position++] = mDepot;
+	bool firstRoute = true;
+	for (int city : mCustomers)
+	{
+		if (previous[city] != -1)
+		{
+			continue;
+		}
+		if (!firstRoute)
+		{
+			individual[position++] = GeneticAlgorithm::sBlank;
+		}
+		firstRoute = false;
+		for (int k = city; k != -1; k = next[k])
+		{
+			individual[position++] = k;
+		}
+	}
+}
+
+void Construction::Sweep(Xoshiro256& random, int* individual) const
+{
+	static thread_local std::vector<int> tour;
+	const int size = static_cast<int>(mSweepOrder.size());
+	std::uniform_int_distribution<int> distribution(0, size - 1);
+	const int start = distribution(random);
+	const bool clockwise = (random() & 1U) != 0U;
+
+	tour.resize(size);
+	for (int i = 0; i < size; i++)
+	{
+		tour[i] = mSweepOrder[(start + (clockwise ? size - i : i)) % size];
+	}
+	SplitTour(tour, individual);
+}
+
+void Construction::SplitTour(const std::vector<int>& tour, int* individual) const
+{
+	static thread_local Split split;
+	static thread_local std::vector<int> routeEnds;
+	const int vehicles = mGa->GetVehicles();
+	routeEnds.resize(vehicles);
+	split.Decode(*mDistances, mDepot, tour.data(), static_cast<int>(tour.size()), vehicles,
+		mDemands, mCapacity, mGa->GetSplitPenalty(), routeEnds.data());
+
+	int position = 0;
+	individual[position++] = mDepot;
+	int begin = 0;
+	for (int route = 0; route < vehicles; route++)
+	{
+		if (route > 0)
+		{
+			individual[position++] = GeneticAlgorithm::sBlank;
+		}
+		for (int k = begin; k < routeEnds[route]; k++)
+		{
+			individual[position++] = tour[k];
+		}
+		begin = routeEnds[route];
+	}
+}
\ No newline at end of file
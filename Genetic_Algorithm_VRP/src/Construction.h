@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "DistanceOracle.h"
+#include "NeighbourIndex.h"
+#include "Random.h"
+
+class GeneticAlgorithm;
+
+// Construction heuristics that seed part of the initial population. Every individual is written in the separator form
+// with exactly the fleet size of non-empty routes, starting at the depot of the instance (the city next to the centre
+// of the coordinates if the depot is evolved). Capacity is respected where the heuristic can, time windows are left
+// to the fitness:
+// - NearestNeighbour: tour that continues with a random one of the nearest unvisited cities, cut into routes by Split
+// - Savings: Clarke and Wright, routes are joined in the order of d(i, depot) + d(depot, j) - d(i, j) until the fleet
+//   size is reached, a random part of the list is skipped so that every individual differs
+// - Sweep: customers in the order of their polar angle around the depot from a random start, cut into routes by Split
+// Setup prepares the data that all individuals share, Build only reads it and can run on several threads
+class Construction
+{
+public:
+	enum class Method
+	{
+		NearestNeighbour,
+		Savings,
+		Sweep
+	};
+	static const int sNumMethods = 3;
+
+	Construction();
+
+	// Takes the instance of ga and sorts the savings list in parallel, has to be called before Build
+	void Setup(const GeneticAlgorithm& ga);
+
+	// Writes one individual of mRouteSize entries, Sweep falls back to NearestNeighbour without coordinates
+	void Build(Method method, Xoshiro256& random, int* individual) const;
+
+	int GetDepot() const { return mDepot; }
+	bool HasCoordinates() const { return !mSweepOrder.empty(); }
+	static const char* MethodName(Method method);
+
+private:
+	struct Saving
+	{
+		int Value;	// d(From, depot) + d(depot, To) - d(From, To)
+		int From;	// Last customer of the first route
+		int To;		// First customer of the second route
+	};
+
+	static const int sCandidates = 3;	// The nearest neighbour heuristic picks one of this many nearest unvisited cities
+	static const double sSkipRate;		// Probability that the savings heuristic skips a feasible join
+
+	const GeneticAlgorithm*	mGa;
+	const DistanceOracle*	mDistances;
+	const NeighbourIndex*	mNeighbours;	// nullptr without index, the candidates are all cities then
+	const int*				mDemands;		// nullptr without demands
+	int						mCapacity;		// 0 if the vehicles have no capacity
+	int						mDepot;
+	std::vector<int>		mCustomers;		// All cities except the depot
+	std::vector<Saving>		mSavings;		// Positive savings, largest first
+	std::vector<int>		mSweepOrder;	// Customers by polar angle around the depot, empty without coordinates
+
+	void NearestNeighbour(Xoshiro256& random, int* individual) const;
+	void Savings(Xoshiro256& random, int* individual) const;
+	void Sweep(Xoshiro256& random, int* individual) const;
+
+	// Cuts the tour of all customers into the routes of the individual with Split
+	void SplitTour(const std::vector<int>& tour, int* individual) const;
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <filesystem>
+
+#include "DistanceCache.h"
+#include "DistanceMatrix.h"
+#include "InstanceReader.h"
+#include "MappedFile.h"
+#include "NeighbourIndex.h"
+#include "Util.h"
+
+namespace
+{
+	const char sMagic[8] = { 'V', 'R', 'P', 'D', 'I', 'S', 'T', '\0' };
+
+	struct Header
+	{
+		char		Magic[8];
+		uint32_t	Version;
+		uint32_t	Mode;			// calculateMissingRoutes
+		uint64_t	InputHash;		// Hash of the input file
+		uint64_t	PayloadHash;	// Hash of everything after the header
+		uint64_t	FileSize;
+		uint32_t	NumCities;
+		uint32_t	Stride;			// Ints per matrix row
+		uint32_t	NumDemands;		// 0 (no city has a demand) or NumCities
+		int32_t		Capacity;
+		int32_t		Depot;
+		uint32_t	NumTimeWindows;	// 0 or NumCities, 3 ints (ready, due, service) each
+		uint64_t	NamesOffset;
+		uint64_t	MatrixOffset;
+		uint64_t	NeighboursOffset;	// Directly behind the matrix
+		uint64_t	NumNeighbourIds;
+		int32_t		NeighbourK;			// 0 if the cache has no neighbour index
+		uint32_t	NeighbourDirection;	// NeighbourIndex::Direction
+	};
+
+	struct CityRecord
+	{
+		uint32_t	NameOffset;		// Relative to Header::NamesOffset
+		uint32_t	NameLength;
+		float		X;
+		float		Y;
+	};
+}
+
+std::string DistanceCache::CachePath(const std::string& inputPath, bool calculateMissingRoutes)
+{
+	return inputPath + (calculateMissingRoutes ? ".routes.cache" : ".roads.cache");
+}
+
+bool DistanceCache::Load(const std::string& cachePath, uint64_t inputHash, bool calculateMissingRoutes, bool verifyPayload, Instance& instance)
+{
+	auto file = std::make_shared<MappedFile>();
+	if (!file->Open(cachePath))
+	{
+		return false;
+	}
+
+	Header header;
+	if (file->Size() < sizeof(Header))
+	{
+		std::cout << "Distance cache " << cachePath << " is corrupt, rebuilding" << std::endl;
+		return false;
+	}
+	memcpy(&header, file->Data(), sizeof(Header));
+
+	if (memcmp(header.Magic, sMagic, sizeof(sMagic)) != 0 || header.FileSize != file->Size())
+	{
+		std::cout << "Distance cache " << cachePath << " is corrupt, rebuilding" << std::endl;
+		return false;
+	}
+	if (header.Version != sVersion || header.InputHash != inputHash || header.Mode != (calculateMissingRoutes ? 1U : 0U))
+	{
+		std::cout << "Distance cache " << cachePath << " is stale, rebuilding" << std::endl;
+		return false;
+	}
+
+	// Offsets have to fit into the file before the payload is touched
+	uint64_t numCities = header.NumCities;
+	uint64_t matrixSize = numCities * header.Stride * sizeof(int);
+	uint64_t neighboursSize = header.NeighbourK > 0 ? (numCities + 1 + header.NumNeighbourIds) * sizeof(uint32_t) : 0U;
+	if (header.Stride != Util::PadToCacheLine<int>(header.NumCities)
+		|| (header.NumDemands != 0U && header.NumDemands != header.NumCities)
+		|| (header.NumTimeWindows != 0U && header.NumTimeWindows != header.NumCities)
+		|| header.NamesOffset < sizeof(Header) + numCities * sizeof(CityRecord) + header.NumDemands * sizeof(int32_t) + header.NumTimeWindows * sizeof(TimeWindow)
+		|| header.MatrixOffset < header.NamesOffset
+		|| header.MatrixOffset % Util::sCacheLineSize != 0U
+		|| header.MatrixOffset + matrixSize != header.NeighboursOffset
+		|| header.NeighboursOffset + neighboursSize != header.FileSize
+		|| (verifyPayload && Util::HashBytes(file->Data() + sizeof(Header), file->Size() - sizeof(Header)) != header.PayloadHash))
+	{
+		std::cout << "Distance cache " << cachePath << " is corrupt, rebuilding" << std::endl;
+		return false;
+	}
+
+	const char* records = file->Data() + sizeof(Header);
+	const char* names = file->Data() + header.NamesOffset;
+	std::vector<City> loaded(numCities);
+	for (size_t i = 0; i < numCities; i++)
+	{
+		CityRecord record;
+		memcpy(&record, records + i * sizeof(CityRecord), sizeof(CityRecord));
+		if (header.NamesOffset + record.NameOffset + record.NameLength > header.MatrixOffset)
+		{
+			std::cout << "Distance cache " << cachePath << " is corrupt, rebuilding" << std::endl;
+			return false;
+		}
+		loaded[i] = City{ std::string(names + record.NameOffset, record.NameLength), record.X, record.Y, 0 };
+	}
+	for (size_t i = 0; i < header.NumDemands; i++)
+	{
+		int32_t demand;
+		memcpy(&demand, records + numCities * sizeof(CityRecord) + i * sizeof(int32_t), sizeof(int32_t));
+		loaded[i].Demand = demand;
+	}
+	std::vector<TimeWindow> timeWindows(header.NumTimeWindows);
+	if (!timeWindows.empty())
+	{
+		memcpy(timeWindows.data(), records + numCities * sizeof(CityRecord) + header.NumDemands * sizeof(int32_t), timeWindows.size() * sizeof(TimeWindow));
+	}
+
+	// Neighbour index is copied, it is small compared to the matrix
+	if (header.NeighbourK > 0)
+	{
+		const char* neighbours = file->Data() + header.NeighboursOffset;
+		std::vector<uint32_t> offsets(numCities + 1);
+		std::vector<uint32_t> ids(header.NumNeighbourIds);
+		memcpy(offsets.data(), neighbours, offsets.size() * sizeof(uint32_t));
+		if (!ids.empty())
+		{
+			memcpy(ids.data(), neighbours + offsets.size() * sizeof(uint32_t), ids.size() * sizeof(uint32_t));
+		}
+		auto index = std::make_shared<NeighbourIndex>();
+		if (!index->Assign(header.NeighbourK, static_cast<NeighbourIndex::Direction>(header.NeighbourDirection), std::move(offsets), std::move(ids)))
+		{
+			std::cout << "Distance cache " << cachePath << " is corrupt, rebuilding" << std::endl;
+			return false;
+		}
+		instance.Neighbours = index;
+	}
+
+	// Matrix is used in place, the mapping lives as long as the matrix
+	const int* matrix = reinterpret_cast<const int*>(file->Data() + header.MatrixOffset);
+	instance.Distances = std::make_shared<const DistanceMatrix>(file, matrix, static_cast<int>(numCities));
+	instance.Cities.swap(loaded);
+	instance.TimeWindows.swap(timeWindows);
+	instance.Capacity = header.Capacity;
+	instance.Depot = header.Depot;
+	instance.HasMissingRoutes = false;
+	return true;
+}
+
+bool DistanceCache::Save(const std::string& cachePath, uint64_t inputHash, bool calculateMissingRoutes, const Instance& instance)
+{
+	const std::vector<City>& cities = instance.Cities;
+	const DistanceMatrix& distances = *instance.Distances;
+
+	Header header = {};
+	memcpy(header.Magic, sMagic, sizeof(sMagic));
+	header.Version = sVersion;
+	header.Mode = calculateMissingRoutes ? 1U : 0U;
+	header.InputHash = inputHash;
+	header.NumCities = static_cast<uint32_t>(distances.Size());
+	header.Stride = static_cast<uint32_t>(distances.Stride());
+	bool hasDemands = std::any_of(cities.begin(), cities.end(), [](const City& city) { return city.Demand != 0; });
+	header.NumDemands = hasDemands ? static_cast<uint32_t>(cities.size()) : 0U;
+	header.Capacity = instance.Capacity;
+	header.Depot = instance.Depot;
+
+	// Build everything after the header in memory to hash it
+	std::vector<char> payload(cities.size() * sizeof(CityRecord));
+	std::string names;
+	for (size_t i = 0; i < cities.size(); i++)
+	{
+		CityRecord record = { static_cast<uint32_t>(names.size()), static_cast<uint32_t>(cities[i].Name.size()), cities[i].X, cities[i].Y };
+		memcpy(payload.data() + i * sizeof(CityRecord), &record, sizeof(CityRecord));
+		names += cities[i].Name;
+	}
+	for (size_t i = 0; i < header.NumDemands; i++)
+	{
+		int32_t demand = cities[i].Demand;
+		const char* bytes = reinterpret_cast<const char*>(&demand);
+		payload.insert(payload.end(), bytes, bytes + sizeof(int32_t));
+	}
+	header.NumTimeWindows = static_cast<uint32_t>(instance.TimeWindows.size());
+	const char* timeWindows = reinterpret_cast<const char*>(instance.TimeWindows.data());
+	payload.insert(payload.end(), timeWindows, timeWindows + instance.TimeWindows.size() * sizeof(TimeWindow));
+	header.NamesOffset = sizeof(Header) + payload.size();
+	payload.insert(payload.end(), names.begin(), names.end());
+
+	header.MatrixOffset = Util::PadToCacheLine<char>(sizeof(Header) + payload.size());
+	payload.resize(header.MatrixOffset - sizeof(Header), '\0');
+	size_t matrixSize = static_cast<size_t>(distances.Size()) * distances.Stride() * sizeof(int);
+	const char* matrix = reinterpret_cast<const char*>(distances.Data());
+	payload.insert(payload.end(), matrix, matrix + matrixSize);
+
+	header.NeighboursOffset = sizeof(Header) + payload.size();
+	if (instance.Neighbours != nullptr)
+	{
+		const NeighbourIndex& neighbours = *instance.Neighbours;
+		header.NeighbourK = neighbours.K();
+		header.NeighbourDirection = static_cast<uint32_t>(neighbours.GetDirection());
+		header.NumNeighbourIds = neighbours.Ids().size();
+		const char* offsets = reinterpret_cast<const char*>(neighbours.Offsets().data());
+		const char* ids = reinterpret_cast<const char*>(neighbours.Ids().data());
+		payload.insert(payload.end(), offsets, offsets + neighbours.Offsets().size() * sizeof(uint32_t));
+		payload.insert(payload.end(), ids, ids + neighbours.Ids().size() * sizeof(uint32_t));
+	}
+
+	header.FileSize = sizeof(Header) + payload.size();
+	header.PayloadHash = Util::HashBytes(payload.data(), payload.size());
+
+	// Unique temporary name, another process may write the same cache at the same time
+	std::string tempPath = cachePath + ".tmp" + std::to_string(std::random_device{}());
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+		if (!file)
+		{
+			file.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
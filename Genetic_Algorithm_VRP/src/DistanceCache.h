@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct Instance;
+
+// Binary cache of the instance (cities, demands, distance matrix, neighbour index) computed by GeneticAlgorithm::ReadFile.
+// The file is keyed by a hash of the input file and the calculateMissingRoutes mode and is loaded
+// with mmap, so the matrix is used in place and shared between processes through the page cache.
+//
+// Layout: Header | CityRecord[numCities] | demands | time windows | names | padding | matrix (numCities rows of Stride ints)
+// | neighbour offsets (numCities + 1) | neighbour ids, the matrix starts at a cache line boundary.
+namespace DistanceCache
+{
+	// Incremented whenever the layout changes, older files are rebuilt
+	const uint32_t sVersion = 4U;
+
+	// Cache file that belongs to an input file, one per mode
+	std::string CachePath(const std::string& inputPath, bool calculateMissingRoutes);
+
+	// Returns false if the file is missing, stale (other input or mode) or corrupt. Only the header is checked by default,
+	// so the matrix stays lazily paged in; verifyPayload also hashes all of it, which reads the whole file
+	bool Load(const std::string& cachePath, uint64_t inputHash, bool calculateMissingRoutes, bool verifyPayload, Instance& instance);
+
+	// Writes to a temporary file and renames it, concurrent readers never see a partial cache
+	bool Save(const std::string& cachePath, uint64_t inputHash, bool calculateMissingRoutes, const Instance& instance);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include <new>
+
+#include "DistanceMatrix.h"
+#include "MappedFile.h"
+#include "Util.h"
+
+DistanceMatrix::DistanceMatrix(int numCities)
+	: mData(nullptr)
+	, mNumCities(numCities)
+	, mStride(static_cast<int>(Util::PadToCacheLine<int>(numCities)))
+{
+	size_t count = static_cast<size_t>(mNumCities) * mStride;
+	mData = static_cast<int*>(Util::AlignedAlloc(Util::sCacheLineSize, sizeof(int) * (count > 0U ? count : 1U)));
+	if (mData == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		mData[i] = 0;
+	}
+}
+
+DistanceMatrix::DistanceMatrix(const std::shared_ptr<const MappedFile>& mapping, const int* data, int numCities)
+	: mData(const_cast<int*>(data))
+	, mNumCities(numCities)
+	, mStride(static_cast<int>(Util::PadToCacheLine<int>(numCities)))
+	, mMapping(mapping)
+{
+}
+
+DistanceMatrix::~DistanceMatrix()
+{
+	if (mMapping == nullptr)
+	{
+		Util::AlignedFree(mData);
+	}
+}
\ No newline at end of file
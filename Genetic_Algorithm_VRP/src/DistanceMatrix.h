@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+class MappedFile;
+
+// Dense N x N distance matrix stored row-major in one cache line aligned block.
+// Once filled it is shared read-only (std::shared_ptr<const DistanceMatrix>) between all solver instances.
+class DistanceMatrix
+{
+public:
+	explicit DistanceMatrix(int numCities);
+
+	// Read-only view of a matrix inside a mapped file (see DistanceCache), must only be used as const
+	DistanceMatrix(const std::shared_ptr<const MappedFile>& mapping, const int* data, int numCities);
+	~DistanceMatrix();
+
+	DistanceMatrix(const DistanceMatrix&) = delete;
+	DistanceMatrix& operator=(const DistanceMatrix&) = delete;
+
+	// Row view, allows matrix[from][to]
+	int* operator[](int from) { return mData + static_cast<size_t>(from) * mStride; }
+	const int* operator[](int from) const { return mData + static_cast<size_t>(from) * mStride; }
+
+	int Size() const { return mNumCities; }
+	int Stride() const { return mStride; }
+	const int* Data() const { return mData; }
+
+private:
+	int*	mData;			// Flat, aligned storage of all rows
+	int		mNumCities;		// Number of rows and columns
+	int		mStride;		// Distance between two rows in ints, padded to whole cache lines
+	std::shared_ptr<const MappedFile>	mMapping;	// Owner of mData if the matrix is mapped, nullptr otherwise
+};
\ No newline at end of file
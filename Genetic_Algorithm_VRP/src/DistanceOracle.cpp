@@ -0,0 +1,227 @@
+#include <cmath>
+#include <algorithm>
+
+#include "DistanceOracle.h"
+
+namespace
+{
+	const double sGeoRadius = 6378.388;		// TSPLIB earth radius
+	const double sEarthRadius = 6371.0;		// Mean earth radius in km
+
+	inline int NearestInt(double value)
+	{
+		return static_cast<int>(value + 0.5);
+	}
+
+	// Latitude/longitude in radians from TSPLIB's DDD.MM format
+	double GeoRadians(double value)
+	{
+		const double pi = 3.141592;
+		int degrees = static_cast<int>(value);
+		double minutes = value - degrees;
+		return pi * (degrees + 5.0 * minutes / 3.0) / 180.0;
+	}
+
+	inline int Euclidean(double dx, double dy)
+	{
+		return NearestInt(std::sqrt(dx * dx + dy * dy));
+	}
+
+	inline int EuclideanCeil(double dx, double dy)
+	{
+		return static_cast<int>(std::ceil(std::sqrt(dx * dx + dy * dy)));
+	}
+
+	inline int Pseudoeuclidean(double dx, double dy)
+	{
+		double distance = std::sqrt((dx * dx + dy * dy) / 10.0);
+		int rounded = NearestInt(distance);
+		return rounded < distance ? rounded + 1 : rounded;
+	}
+
+	// Arguments are in radians
+	inline int Geographical(double latitude1, double longitude1, double latitude2, double longitude2)
+	{
+		double q1 = std::cos(longitude1 - longitude2);
+		double q2 = std::cos(latitude1 - latitude2);
+		double q3 = std::cos(latitude1 + latitude2);
+		return static_cast<int>(sGeoRadius * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+	}
+
+	inline int GreatCircle(double latitude1, double longitude1, double cos1, double latitude2, double longitude2, double cos2)
+	{
+		double sinLatitude = std::sin((latitude1 - latitude2) * 0.5);
+		double sinLongitude = std::sin((longitude1 - longitude2) * 0.5);
+		double a = sinLatitude * sinLatitude + cos1 * cos2 * sinLongitude * sinLongitude;
+		return NearestInt(2.0 * sEarthRadius * std::asin(std::sqrt(a)));
+	}
+}
+
+DistanceOracle::DistanceOracle(const std::shared_ptr<const DistanceMatrix>& matrix)
+	: mMatrix(matrix)
+	, mData(matrix->Data())
+	, mStride(static_cast<size_t>(matrix->Stride()))
+	, mMetric(Metric::Matrix)
+	, mSize(matrix->Size())
+{
+}
+
+DistanceOracle::DistanceOracle(Metric metric, const std::vector<double>& x, const std::vector<double>& y)
+	: mMatrix(nullptr)
+	, mData(nullptr)
+	, mStride(0U)
+	, mMetric(metric)
+	, mSize(static_cast<int>(x.size()))
+	, mX(x)
+	, mY(y)
+{
+	const double degrees = 3.14159265358979323846 / 180.0;
+	for (int i = 0; i < mSize; i++)
+	{
+		if (mMetric == Metric::Geographical)
+		{
+			mX[i] = GeoRadians(x[i]);
+			mY[i] = GeoRadians(y[i]);
+		}
+		else if (mMetric == Metric::GreatCircle)
+		{
+			mX[i] = x[i] * degrees;
+			mY[i] = y[i] * degrees;
+			mCosX.push_back(std::cos(mX[i]));
+		}
+	}
+}
+
+int DistanceOracle::Compute(int from, int to) const
+{
+	if (from == to)
+	{
+		return 0;
+	}
+
+	switch (mMetric)
+	{
+	case Metric::Euclidean:
+		return Euclidean(mX[from] - mX[to], mY[from] - mY[to]);
+	case Metric::EuclideanCeil:
+		return EuclideanCeil(mX[from] - mX[to], mY[from] - mY[to]);
+	case Metric::Pseudoeuclidean:
+		return Pseudoeuclidean(mX[from] - mX[to], mY[from] - mY[to]);
+	case Metric::Geographical:
+		return Geographical(mX[from], mY[from], mX[to], mY[to]);
+	case Metric::GreatCircle:
+		return GreatCircle(mX[from], mY[from], mCosX[from], mX[to], mY[to], mCosX[to]);
+	default:
+		return 0;
+	}
+}
+
+void DistanceOracle::Batch(const int* from, const int* to, int count, int* out) const
+{
+	const double* x = mX.data();
+	const double* y = mY.data();
+
+	// Gathers of the coordinates, the arithmetic runs on full vectors
+	switch (mMetric)
+	{
+	case Metric::Matrix:
+		for (int k = 0; k < count; k++)
+		{
+			out[k] = mData[static_cast<size_t>(from[k]) * mStride + to[k]];
+		}
+		break;
+	case Metric::Euclidean:
+#pragma omp simd
+		for (int k = 0; k < count; k++)
+		{
+			out[k] = Euclidean(x[from[k]] - x[to[k]], y[from[k]] - y[to[k]]);
+		}
+		break;
+	case Metric::EuclideanCeil:
+#pragma omp simd
+		for (int k = 0; k < count; k++)
+		{
+			out[k] = EuclideanCeil(x[from[k]] - x[to[k]], y[from[k]] - y[to[k]]);
+		}
+		break;
+	case Metric::Pseudoeuclidean:
+#pragma omp simd
+		for (int k = 0; k < count; k++)
+		{
+			out[k] = Pseudoeuclidean(x[from[k]] - x[to[k]], y[from[k]] - y[to[k]]);
+		}
+		break;
+	default:
+		// Trigonometric metrics
+		for (int k = 0; k < count; k++)
+		{
+			out[k] = Compute(from[k], to[k]);
+		}
+		return;
+	}
+
+	// Distance of a city to itself is 0 for all metrics (GEO would give 1)
+	for (int k = 0; k < count; k++)
+	{
+		if (from[k] == to[k])
+		{
+			out[k] = 0;
+		}
+	}
+}
+
+void DistanceOracle::FillMatrix(DistanceMatrix& matrix) const
+{
+#pragma omp parallel
+	{
+		std::vector<int> from(mSize);
+		std::vector<int> to(mSize);
+		for (int j = 0; j < mSize; j++)
+		{
+			to[j] = j;
+		}
+
+#pragma omp for schedule(dynamic, 16)
+		for (int i = 0; i < mSize; i++)
+		{
+			std::fill(from.begin(), from.end(), i);
+			Batch(from.data(), to.data(), mSize, matrix[i]);
+		}
+	}
+}
+
+bool DistanceOracle::ParseMetric(const std::string& name, Metric& metric)
+{
+	const Metric metrics[] = { Metric::Matrix, Metric::Native, Metric::Euclidean, Metric::EuclideanCeil, Metric::Geographical, Metric::Pseudoeuclidean, Metric::GreatCircle };
+	for (Metric candidate : metrics)
+	{
+		if (name == MetricName(candidate))
+		{
+			metric = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* DistanceOracle::MetricName(Metric metric)
+{
+	switch (metric)
+	{
+	case Metric::Matrix:
+		return "matrix";
+	case Metric::Native:
+		return "coordinates";
+	case Metric::Euclidean:
+		return "euclidean";
+	case Metric::EuclideanCeil:
+		return "euclidean-ceil";
+	case Metric::Geographical:
+		return "geo";
+	case Metric::Pseudoeuclidean:
+		return "att";
+	case Metric::GreatCircle:
+		return "great-circle";
+	}
+	return "";
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DistanceMatrix.h"
+
+// Distance between two cities, looked up in a dense N x N matrix or computed on demand from
+// the city coordinates. The coordinate metrics need O(N) memory and allow instances that are
+// too large for a matrix. All coordinate metrics are symmetric.
+class DistanceOracle
+{
+public:
+	enum class Metric
+	{
+		Matrix,				// Dense matrix lookup
+		Native,				// Only as request: metric of the input (TSPLIB EDGE_WEIGHT_TYPE, GreatCircle for city facts)
+		Euclidean,			// TSPLIB EUC_2D, rounded to the nearest integer
+		EuclideanCeil,		// TSPLIB CEIL_2D
+		Geographical,		// TSPLIB GEO, coordinates in DDD.MM format
+		Pseudoeuclidean,	// TSPLIB ATT
+		GreatCircle			// Haversine distance in km, X is the latitude and Y the longitude in decimal degrees
+	};
+
+	explicit DistanceOracle(const std::shared_ptr<const DistanceMatrix>& matrix);
+	DistanceOracle(Metric metric, const std::vector<double>& x, const std::vector<double>& y);
+
+	DistanceOracle(const DistanceOracle&) = delete;
+	DistanceOracle& operator=(const DistanceOracle&) = delete;
+
+	int operator()(int from, int to) const
+	{
+		if (mData != nullptr)
+		{
+			return mData[static_cast<size_t>(from) * mStride + to];
+		}
+		return Compute(from, to);
+	}
+
+	// out[k] = distance(from[k], to[k]), vectorized for the coordinate metrics
+	void Batch(const int* from, const int* to, int count, int* out) const;
+
+	// Writes all distances into matrix, rows are computed in parallel
+	void FillMatrix(DistanceMatrix& matrix) const;
+
+	int Size() const { return mSize; }
+	Metric GetMetric() const { return mMetric; }
+	bool IsMatrix() const { return mMatrix != nullptr; }
+
+	// Matrix that is used for lookups, nullptr for coordinate metrics
+	const std::shared_ptr<const DistanceMatrix>& Matrix() const { return mMatrix; }
+
+	static bool ParseMetric(const std::string& name, Metric& metric);
+	static const char* MetricName(Metric metric);
+
+private:
+	int Compute(int from, int to) const;
+
+	std::shared_ptr<const DistanceMatrix>	mMatrix;	// Only for Metric::Matrix
+	const int*			mData;		// mMatrix data, nullptr for coordinate metrics
+	size_t				mStride;
+	Metric				mMetric;
+	int					mSize;		// Number of cities
+
+	// Coordinates prepared for mMetric (radians for the spherical metrics)
+	std::vector<double>	mX;
+	std::vector<double>	mY;
+	std::vector<double>	mCosX;		// Cosine of the latitude for GreatCircle
+};
\ No newline at end of file
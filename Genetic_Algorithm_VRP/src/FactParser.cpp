@@ -0,0 +1,250 @@
+#include <iostream>
+#include <charconv>
+#include <algorithm>
+#include <omp.h>
+
+#include "FactParser.h"
+
+const size_t FactParser::sMinChunkSize = 256U * 1024U;
+
+namespace
+{
+	bool IsWhitespace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	const char* SkipWhitespace(const char* current, const char* end)
+	{
+		while (current < end && IsWhitespace(*current))
+		{
+			current++;
+		}
+		return current;
+	}
+
+	// Reads a name up to the next ',' or ')', trailing whitespace is cut off
+	const char* ParseName(const char* current, const char* end, std::string_view& name)
+	{
+		current = SkipWhitespace(current, end);
+		const char* begin = current;
+		while (current < end && *current != ',' && *current != ')')
+		{
+			current++;
+		}
+		const char* last = current;
+		while (last > begin && IsWhitespace(last[-1]))
+		{
+			last--;
+		}
+		name = std::string_view(begin, static_cast<size_t>(last - begin));
+		return name.empty() ? nullptr : current;
+	}
+
+	template<typename T>
+	const char* ParseNumber(const char* current, const char* end, T& value)
+	{
+		current = SkipWhitespace(current, end);
+		std::from_chars_result result = std::from_chars(current, end, value);
+		return result.ec == std::errc() ? SkipWhitespace(result.ptr, end) : nullptr;
+	}
+
+	const char* Expect(const char* current, const char* end, char c)
+	{
+		current = SkipWhitespace(current, end);
+		return current < end && *current == c ? current + 1 : nullptr;
+	}
+
+	bool StartsWith(const char* current, const char* end, std::string_view value)
+	{
+		return static_cast<size_t>(end - current) >= value.size() && std::string_view(current, value.size()) == value;
+	}
+}
+
+FactParser::FactParser()
+	: mNames(64U)
+{
+}
+
+bool FactParser::ParseFile(const std::string& path, int maxChunks)
+{
+	if (!mFile.Open(path, true))
+	{
+		std::cout << "Could not open " << path << std::endl;
+		return false;
+	}
+	return Parse(mFile.Data(), mFile.Size(), maxChunks);
+}
+
+bool FactParser::Parse(const char* data, size_t size, int maxChunks)
+{
+	// Split at line ends, every chunk gets at least sMinChunkSize bytes
+	int numChunks = static_cast<int>(std::min<size_t>(static_cast<size_t>(std::max(maxChunks, 1)), size / sMinChunkSize + 1U));
+	std::vector<const char*> bounds(numChunks + 1, data + size);
+	bounds[0] = data;
+	for (int i = 1; i < numChunks; i++)
+	{
+		const char* bound = std::max(data + size / numChunks * i, bounds[i - 1]);
+		while (bound < data + size && bound[-1] != '\n')
+		{
+			bound++;
+		}
+		bounds[i] = bound;
+	}
+
+	std::vector<Chunk> chunks(numChunks);
+#pragma omp parallel for schedule(static, 1) if(numChunks > 1)
+	for (int i = 0; i < numChunks; i++)
+	{
+		ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+	}
+
+	// Cities are numbered in file order
+	size_t numCities = 0U;
+	size_t numRoads = 0U;
+	int errors = 0;
+	for (const Chunk& chunk : chunks)
+	{
+		numCities += chunk.Cities.size();
+		numRoads += chunk.Roads.size();
+		errors += chunk.Errors;
+	}
+	mNames = NameTable(numCities);
+	mCities.clear();
+	mCities.reserve(numCities);
+	for (const Chunk& chunk : chunks)
+	{
+		for (const CityFact& city : chunk.Cities)
+		{
+			if (mNames.Insert(city.Name) == static_cast<int>(mCities.size()))
+			{
+				mCities.push_back(city);
+			}
+			else
+			{
+				std::cout << "Ignoring duplicate city " << city.Name << std::endl;
+			}
+		}
+	}
+
+	// Resolve road names, the table is read-only from now on
+	std::vector<size_t> offsets(numChunks + 1, 0U);
+	for (int i = 0; i < numChunks; i++)
+	{
+		offsets[i + 1] = offsets[i] + chunks[i].Roads.size();
+	}
+	mRoads.resize(numRoads);
+	int unknown = 0;
+#pragma omp parallel for schedule(static, 1) reduction(+:unknown) if(numChunks > 1)
+	for (int i = 0; i < numChunks; i++)
+	{
+		RoadFact* roads = mRoads.data() + offsets[i];
+		for (const RawRoad& road : chunks[i].Roads)
+		{
+			*roads = RoadFact{ mNames.Find(road.City1), mNames.Find(road.City2), road.Distance };
+			if (roads->City1 < 0 || roads->City2 < 0)
+			{
+				unknown++;
+			}
+			roads++;
+		}
+	}
+
+	if (errors > 0)
+	{
+		std::cout << "Skipped " << errors << " malformed facts" << std::endl;
+	}
+	if (unknown > 0)
+	{
+		std::cout << unknown << " roads connect unknown cities" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void FactParser::ParseChunk(const char* begin, const char* end, Chunk& chunk)
+{
+	const char* current = begin;
+	while (current < end)
+	{
+		const char* lineEnd = current;
+		while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '%')
+		{
+			lineEnd++;
+		}
+
+		// Only lines starting with a fact are read, other Prolog clauses (rules) are skipped.
+		// Such a line can hold any number of facts
+		if (!StartsWith(current, lineEnd, "road") && !StartsWith(current, lineEnd, "city"))
+		{
+			current = lineEnd;
+		}
+		while (current < lineEnd)
+		{
+			const char* next = ParseFact(current, lineEnd, chunk);
+			if (next == nullptr)
+			{
+				chunk.Errors++;
+				break;
+			}
+			current = SkipWhitespace(next, lineEnd);
+		}
+
+		// Skip comment
+		current = lineEnd;
+		while (current < end && *current != '\n')
+		{
+			current++;
+		}
+		current++;
+	}
+}
+
+const char* FactParser::ParseFact(const char* current, const char* end, Chunk& chunk)
+{
+	if (StartsWith(current, end, "road"))
+	{
+		RawRoad road;
+		if ((current = Expect(current + 4, end, '(')) == nullptr
+			|| (current = ParseName(current, end, road.City1)) == nullptr
+			|| (current = Expect(current, end, ',')) == nullptr
+			|| (current = ParseName(current, end, road.City2)) == nullptr
+			|| (current = Expect(current, end, ',')) == nullptr
+			|| (current = ParseNumber(current, end, road.Distance)) == nullptr)
+		{
+			return nullptr;
+		}
+		chunk.Roads.push_back(road);
+	}
+	else if (StartsWith(current, end, "city"))
+	{
+		CityFact city;
+		if ((current = Expect(current + 4, end, '(')) == nullptr
+			|| (current = ParseName(current, end, city.Name)) == nullptr
+			|| (current = Expect(current, end, ',')) == nullptr
+			|| (current = ParseNumber(current, end, city.X)) == nullptr
+			|| (current = Expect(current, end, ',')) == nullptr
+			|| (current = ParseNumber(current, end, city.Y)) == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Optional demand of the customer
+		city.Demand = 0;
+		if (current < end && *current == ',' && (current = ParseNumber(current + 1, end, city.Demand)) == nullptr)
+		{
+			return nullptr;
+		}
+		chunk.Cities.push_back(city);
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	if ((current = Expect(current, end, ')')) == nullptr)
+	{
+		return nullptr;
+	}
+	return Expect(current, end, '.');
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "NameTable.h"
+
+// Parses road(city1, city2, distance). and city(name, x, y[, demand]). facts in place.
+// Only lines that start with a fact are read, everything after a % is a comment.
+// Large inputs are split at line boundaries into chunks that are parsed in parallel.
+class FactParser
+{
+public:
+	struct CityFact
+	{
+		std::string_view	Name;	// View into the parsed buffer
+		float				X;
+		float				Y;
+		int					Demand;	// 0 if the fact has none
+	};
+
+	struct RoadFact
+	{
+		int		City1;		// Index into Cities()
+		int		City2;
+		int		Distance;
+	};
+
+	// Inputs below this size per chunk are not worth splitting
+	static const size_t sMinChunkSize;
+
+	FactParser();
+
+	// Maps the file and parses it, names stay valid as long as the parser exists
+	bool ParseFile(const std::string& path, int maxChunks);
+
+	// Parses an external buffer, it has to outlive the parser
+	bool Parse(const char* data, size_t size, int maxChunks);
+
+	const std::vector<CityFact>& Cities() const { return mCities; }
+	const std::vector<RoadFact>& Roads() const { return mRoads; }
+	const NameTable& Names() const { return mNames; }
+
+private:
+	// Road with names that are not resolved yet
+	struct RawRoad
+	{
+		std::string_view	City1;
+		std::string_view	City2;
+		int					Distance;
+	};
+
+	// Facts of one chunk in file order
+	struct Chunk
+	{
+		std::vector<CityFact>	Cities;
+		std::vector<RawRoad>	Roads;
+		int						Errors = 0;		// Malformed facts
+	};
+
+	static void ParseChunk(const char* begin, const char* end, Chunk& chunk);
+	static const char* ParseFact(const char* current, const char* end, Chunk& chunk);
+
+	MappedFile				mFile;
+	NameTable				mNames;		// City name to index into mCities
+	std::vector<CityFact>	mCities;
+	std::vector<RoadFact>	mRoads;
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <cstdint>
+
+#include "FitnessKernels.h"
+
+// Loops without gathers are compiled once per instruction set (target_clones). The gathers are written with
+// intrinsics in one version per instruction set, because the compiler does not emit gather instructions for the
+// generic tuning
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define FITNESS_MULTIVERSIONING
+#define FITNESS_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#define FITNESS_TARGET(name) __attribute__((target(name)))
+#else
+#define FITNESS_TARGET_CLONES
+#define FITNESS_TARGET(name)
+#endif
+
+namespace
+{
+	// Weights of the fitness formula in units of 2^-24, 0.3f = 5033165 * 2^-24 and 0.7f = 11744051 * 2^-24
+	const int64_t sDistanceWeight = 5033165;
+	const int64_t sBalanceWeight = 11744051;
+	const int sWeightShift = 24;
+
+	// Rounds value to the 24 significant bits of a float, half to even
+	int64_t RoundToFloat(int64_t value)
+	{
+		const uint64_t limit = uint64_t(1) << 24;
+		uint64_t magnitude = value < 0 ? 0U - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+		if (magnitude < limit)
+		{
+			return value;
+		}
+
+		// Bits below the 24 significant ones, binary search for the largest shift that leaves 24 bits, plus one
+		int shift = 0;
+		for (int step = 32; step > 0; step /= 2)
+		{
+			if ((magnitude >> (shift + step)) >= limit)
+			{
+				shift += step;
+			}
+		}
+		shift++;
+
+		const uint64_t rest = magnitude & ((uint64_t(1) << shift) - 1U);
+		const uint64_t half = uint64_t(1) << (shift - 1);
+		magnitude >>= shift;
+		if (rest > half || (rest == half && (magnitude & 1U) != 0U))
+		{
+			magnitude++;
+		}
+		magnitude <<= shift;
+		return value < 0 ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+	}
+
+	// Distance between the positions j - 1 and j, see GatherEdges
+	inline int Edge(const int* matrix, int stride, const int* individual, int j, int blank)
+	{
+		const int previous = individual[j - 1];
+		const int current = individual[j];
+		const int from = previous == blank ? individual[0] : previous;
+		const int to = current == blank ? individual[0] : current;
+		return previous == blank || current == blank ? matrix[from * stride + to] : matrix[to * stride + from];
+	}
+
+	FITNESS_TARGET("default")
+	void GatherEdgesVersion(const int* matrix, int stride, const int* individual, int size, int blank, int* edges)
+	{
+		for (int j = 1; j < size; j++)
+		{
+			edges[j] = Edge(matrix, stride, individual, j, blank);
+		}
+	}
+
+	FITNESS_TARGET("default")
+	void GatherDemandsVersion(const int* demands, const int* individual, int size, int blank, int* values)
+	{
+		for (int j = 0; j < size; j++)
+		{
+			values[j] = individual[j] == blank ? 0 : demands[individual[j]];
+		}
+	}
+
+#ifdef FITNESS_MULTIVERSIONING
+	FITNESS_TARGET("avx2")
+	void GatherEdgesVersion(const int* matrix, int stride, const int* individual, int size, int blank, int* edges)
+	{
+		const __m256i blanks = _mm256_set1_epi32(blank);
+		const __m256i depots = _mm256_set1_epi32(individual[0]);
+		const __m256i strides = _mm256_set1_epi32(stride);
+		int j = 1;
+		for (; j + 8 <= size; j += 8)
+		{
+			const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(individual + j - 1));
+			const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(individual + j));
+			const __m256i previousBlank = _mm256_cmpeq_epi32(previous, blanks);
+			const __m256i currentBlank = _mm256_cmpeq_epi32(current, blanks);
+			const __m256i from = _mm256_blendv_epi8(previous, depots, previousBlank);
+			const __m256i to = _mm256_blendv_epi8(current, depots, currentBlank);
+			const __m256i forward = _mm256_add_epi32(_mm256_mullo_epi32(from, strides), to);
+			const __m256i backward = _mm256_add_epi32(_mm256_mullo_epi32(to, strides), from);
+			const __m256i index = _mm256_blendv_epi8(backward, forward, _mm256_or_si256(previousBlank, currentBlank));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(edges + j), _mm256_i32gather_epi32(matrix, index, 4));
+		}
+		for (; j < size; j++)
+		{
+			edges[j] = Edge(matrix, stride, individual, j, blank);
+		}
+	}
+
+	FITNESS_TARGET("avx2")
+	void GatherDemandsVersion(const int* demands, const int* individual, int size, int blank, int* values)
+	{
+		const __m256i blanks = _mm256_set1_epi32(blank);
+		int j = 0;
+		for (; j + 8 <= size; j += 8)
+		{
+			// Blanks are masked out, they read nothing
+			const __m256i cities = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(individual + j));
+			const __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi32(cities, blanks), _mm256_set1_epi32(-1));
+			const __m256i loads = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), demands, cities, mask, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + j), loads);
+		}
+		for (; j < size; j++)
+		{
+			values[j] = individual[j] == blank ? 0 : demands[individual[j]];
+		}
+	}
+
+	FITNESS_TARGET("avx512f")
+	void GatherEdgesVersion(const int* matrix, int stride, const int* individual, int size, int blank, int* edges)
+	{
+		const __m512i blanks = _mm512_set1_epi32(blank);
+		const __m512i depots = _mm512_set1_epi32(individual[0]);
+		const __m512i strides = _mm512_set1_epi32(stride);
+		int j = 1;
+		for (; j + 16 <= size; j += 16)
+		{
+			const __m512i previous = _mm512_loadu_si512(individual + j - 1);
+			const __m512i current = _mm512_loadu_si512(individual + j);
+			const __mmask16 previousBlank = _mm512_cmpeq_epi32_mask(previous, blanks);
+			const __mmask16 currentBlank = _mm512_cmpeq_epi32_mask(current, blanks);
+			const __m512i from = _mm512_mask_blend_epi32(previousBlank, previous, depots);
+			const __m512i to = _mm512_mask_blend_epi32(currentBlank, current, depots);
+			const __m512i forward = _mm512_add_epi32(_mm512_mullo_epi32(from, strides), to);
+			const __m512i backward = _mm512_add_epi32(_mm512_mullo_epi32(to, strides), from);
+			const __m512i index = _mm512_mask_blend_epi32(previousBlank | currentBlank, backward, forward);
+			// Masked form with all lanes set, the unmasked one warns about its uninitialized source with GCC 12
+			_mm512_storeu_si512(edges + j, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, matrix, 4));
+		}
+		for (; j < size; j++)
+		{
+			edges[j] = Edge(matrix, stride, individual, j, blank);
+		}
+	}
+
+	FITNESS_TARGET("avx512f")
+	void GatherDemandsVersion(const int* demands, const int* individual, int size, int blank, int* values)
+	{
+		const __m512i blanks = _mm512_set1_epi32(blank);
+		int j = 0;
+		for (; j + 16 <= size; j += 16)
+		{
+			const __m512i cities = _mm512_loadu_si512(individual + j);
+			const __mmask16 mask = _mm512_cmpneq_epi32_mask(cities, blanks);
+			_mm512_storeu_si512(values + j, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, cities, demands, 4));
+		}
+		for (; j < size; j++)
+		{
+			values[j] = individual[j] == blank ? 0 : demands[individual[j]];
+		}
+	}
+#endif
+}
+
+void FitnessKernels::GatherEdges(const int* matrix, int stride, const int* individual, int size, int blank, int* edges)
+{
+	GatherEdgesVersion(matrix, stride, individual, size, blank, edges);
+}
+
+void FitnessKernels::GatherDemands(const int* demands, const int* individual, int size, int blank, int* values)
+{
+	GatherDemandsVersion(demands, individual, size, blank, values);
+}
+
+FITNESS_TARGET_CLONES
+int FitnessKernels::Sum(const int* values, int begin, int end)
+{
+	int sum = 0;
+#pragma omp simd reduction(+:sum)
+	for (int j = begin; j < end; j++)
+	{
+		sum += values[j];
+	}
+	return sum;
+}
+
+int FitnessKernels::WeightedFitness(int routeLength, int balance)
+{
+	// The ints are converted to float, both products and the sum are rounded, the result is truncated
+	const int64_t distance = RoundToFloat(sDistanceWeight * RoundToFloat(routeLength));
+	const int64_t difference = RoundToFloat(sBalanceWeight * RoundToFloat(balance));
+	return static_cast<int>(RoundToFloat(distance + difference) / (int64_t(1) << sWeightShift));
+}
\ No newline at end of file
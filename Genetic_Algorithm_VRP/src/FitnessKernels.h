@@ -0,0 +1,22 @@
+#pragma once
+
+// Branch-free loops of the batch evaluation in GeneticAlgorithm::EvaluatePopulation. They are compiled for AVX-512,
+// AVX2 and the baseline instruction set, the loader picks the best version the CPU supports (function multiversioning
+// with GCC and Clang on x86-64, only the baseline version elsewhere). The distance lookups become vector gathers
+namespace FitnessKernels
+{
+	// edges[j] = distance that EvaluateFitness counts between the positions j - 1 and j, for j = 1 .. size - 1.
+	// Blanks read as the depot (individual[0]), an edge next to a blank runs forward (city to depot, depot to city),
+	// all others from position j to j - 1 like the loop of EvaluateFitness. numCities * stride has to fit into an int
+	void GatherEdges(const int* matrix, int stride, const int* individual, int size, int blank, int* edges);
+
+	// values[j] = demands[individual[j]], 0 for blanks
+	void GatherDemands(const int* demands, const int* individual, int size, int blank, int* values);
+
+	// Sum of values[begin] .. values[end - 1]
+	int Sum(const int* values, int begin, int end);
+
+	// (int)(0.3f * routeLength + 0.7f * balance) in 64-bit fixed point: both float weights are exact multiples of 2^-24
+	// and every rounding step of the float formula is done on the integers, so the result is bit-identical to it
+	int WeightedFitness(int routeLength, int balance);
+}
\ No newline at end of file
@@ -6,13 +6,21 @@
 #include <random>
 #include <chrono>
 #include <cmath>
-#include <map>
 #include <stdlib.h>
 #include <algorithm>
+#include <numeric>
+#include <thread>
+#include <omp.h>
 
+#include "Construction.h"
+#include "DistanceCache.h"
+#include "FitnessKernels.h"
 #include "Genetic.h"
+#include "InstanceReader.h"
+#include "MappedFile.h"
 #include "PathFinder.h"
-#include "Timing.h"
+#include "Profiler.h"
+#include "Split.h"
 #include "Util.h"
 
 bool Road::Parse(const std::string& roadString)
@@ -56,210 +64,570 @@ bool City::Parse(const std::string& cityString)
 
 	// Find first digit
 	begin = Util::FindNextNonWhitespace(cityString, comma);
-	Y = std::stof(cityString.substr(begin, closingBracket - begin));
+	comma = cityString.find(',', begin);
+	Y = std::stof(cityString.substr(begin, std::min(comma, closingBracket) - begin));
+
+	// Optional demand of the customer
+	Demand = 0;
+	if (comma < closingBracket)
+	{
+		begin = Util::FindNextNonWhitespace(cityString, comma);
+		Demand = std::stoi(cityString.substr(begin, closingBracket - begin));
+	}
 
 	return true;
 }
 
 const int GeneticAlgorithm::sBlank = -42;
-const int GeneticAlgorithm::sVehicles = 5;
+const int GeneticAlgorithm::sDefaultVehicles = 5;
 
 // Initialize Genetic Algorithm
 GeneticAlgorithm::GeneticAlgorithm()
 	: mDistances(nullptr)
 	, mNumCities(0)
-	, mRouteSize(mNumCities + (sVehicles - 1))
+	, mRouteSize(mNumCities + (sDefaultVehicles - 1))
 	, mPopulationSize(500)
 	, mIterations(100000)
+	, mTimeLimit(0.0)
+	, mMaxStagnation(0)
 	, mMutationRate(0.5)
+	, mInversionMode(InversionMode::Fenwick)
+	, mRepresentation(Representation::Separators)
+	, mLocalSearchRate(0.0)
+	, mHeuristicFraction(0.0)
+	, mNumNeighbours(10)
+	, mNeighbourDirection(NeighbourIndex::Direction::Outgoing)
+	, mTargetFitness(-1)
+	, mUseDistanceCache(true)
+	, mVerifyDistanceCache(false)
+	, mDeltaEvaluation(true)
+	, mBatchEvaluation(true)
+	, mIslandThreads(1)
+	, mMetric(DistanceOracle::Metric::Matrix)
+	, mNeighbourIndex(nullptr)
+	, mCapacity(0)
+	, mCapacityPenalty(100)
+	, mDepot(-1)
+	, mTimeWarpPenalty(100)
 	, mBestSolution()
+	, mBestFitness(INT32_MAX)
+	, mRandom(std::random_device{}())
+	, mMigration(nullptr)
+	, mIsland(0)
+	, mPendingExchange(0)
+	, mTimeToTarget(-1.0)
+	, mStop(nullptr)
+	, mGenerations(0)
+	, mStagnation(0)
+	, mRunStart(std::chrono::steady_clock::time_point::min())
 {
+	SetVehicles(sDefaultVehicles);
 }
 
 GeneticAlgorithm::GeneticAlgorithm(const GeneticAlgorithm& ga)
-	: mDistances(nullptr)
+	: mDistances(ga.mDistances)
 	, mNumCities(ga.mNumCities)
 	, mRouteSize(ga.mRouteSize)
 	, mPopulationSize(ga.mPopulationSize)
 	, mIterations(ga.mIterations)
+	, mTimeLimit(ga.mTimeLimit)
+	, mMaxStagnation(ga.mMaxStagnation)
 	, mMutationRate(ga.mMutationRate)
+	, mInversionMode(ga.mInversionMode)
+	, mRepresentation(ga.mRepresentation)
+	, mLocalSearchRate(ga.mLocalSearchRate)
+	, mHeuristicFraction(ga.mHeuristicFraction)
+	, mNumNeighbours(ga.mNumNeighbours)
+	, mNeighbourDirection(ga.mNeighbourDirection)
+	, mTargetFitness(ga.mTargetFitness)
+	, mUseDistanceCache(ga.mUseDistanceCache)
+	, mVerifyDistanceCache(ga.mVerifyDistanceCache)
+	, mDeltaEvaluation(ga.mDeltaEvaluation)
+	, mBatchEvaluation(ga.mBatchEvaluation)
+	, mIslandThreads(ga.mIslandThreads)
+	, mMetric(ga.mMetric)
+	, mNeighbourIndex(ga.mNeighbourIndex)
 	, mCities(ga.mCities)
-	, mBestSolution(ga.mBestSolution)
+	, mDemands(ga.mDemands)
+	, mCapacity(ga.mCapacity)
+	, mCapacityPenalty(ga.mCapacityPenalty)
+	, mDepot(ga.mDepot)
+	, mTimeWindows(ga.mTimeWindows)
+	, mTimeWarpPenalty(ga.mTimeWarpPenalty)
+	, mBestSolution(nullptr)
+	, mBestFitness(INT32_MAX)
+	, mRandom(std::random_device{}())
+	, mMigration(nullptr)
+	, mIsland(0)
+	, mPendingExchange(0)
+	, mTimeToTarget(-1.0)
+	, mStop(nullptr)
+	, mGenerations(0)
+	, mStagnation(0)
+	, mRunStart(std::chrono::steady_clock::time_point::min())
+	, mVehicles(ga.mVehicles)
+	, mEvaluatePopulationKernel(ga.mEvaluatePopulationKernel)
+	, mEvaluateIndividualKernel(ga.mEvaluateIndividualKernel)
+	, mMutateKernel(ga.mMutateKernel)
+{
+}
 
+GeneticAlgorithm::~GeneticAlgorithm()
 {
-	mDistances = new int* [mNumCities];
-	for (int i = 0; i < mNumCities; i++)
+	delete[] mBestSolution;
+}
+
+void GeneticAlgorithm::SetSeed(uint64_t seed, int stream)
+{
+	mRandom.Seed(seed, stream);
+}
+
+void GeneticAlgorithm::SetMigration(const std::shared_ptr<MigrationHub>& migration, int island)
+{
+	mMigration = migration;
+	mIsland = island;
+}
+
+void GeneticAlgorithm::SetStopFlag(const std::shared_ptr<std::atomic<bool>>& stop)
+{
+	mStop = stop;
+}
+
+void GeneticAlgorithm::SetRunStart(std::chrono::steady_clock::time_point start)
+{
+	mRunStart = start;
+}
+
+bool GeneticAlgorithm::IsStopped() const
+{
+	return mStop != nullptr && mStop->load(std::memory_order_relaxed);
+}
+
+void GeneticAlgorithm::SetVehicles(int vehicles)
+{
+	mVehicles = vehicles;
+	mRouteSize = mNumCities + (mVehicles - 1);
+
+	switch (vehicles)
 	{
-		mDistances[i] = new int[mNumCities];
-		for (int j = 0; j < mNumCities; j++)
-		{
-			mDistances[i][j] = ga.mDistances[i][j];
-		}
+	case 2: SelectKernels<2>(); break;
+	case 3: SelectKernels<3>(); break;
+	case 4: SelectKernels<4>(); break;
+	case 5: SelectKernels<5>(); break;
+	case 6: SelectKernels<6>(); break;
+	case 7: SelectKernels<7>(); break;
+	case 8: SelectKernels<8>(); break;
+	case 9: SelectKernels<9>(); break;
+	case 10: SelectKernels<10>(); break;
+	case 11: SelectKernels<11>(); break;
+	case 12: SelectKernels<12>(); break;
+	case 13: SelectKernels<13>(); break;
+	case 14: SelectKernels<14>(); break;
+	case 15: SelectKernels<15>(); break;
+	case 16: SelectKernels<16>(); break;
+	default: SelectKernels<0>(); break;
 	}
 }
 
-GeneticAlgorithm::~GeneticAlgorithm()
+int GeneticAlgorithm::GetVehicles() const
 {
-	delete[] mBestSolution;
-	if (mDistances != nullptr)
+	return mVehicles;
+}
+
+int GeneticAlgorithm::GetSplitPenalty() const
+{
+	return (mCapacityPenalty * 10 + 1) / 3;
+}
+
+void GeneticAlgorithm::SolveVRP()
+{
+	PROFILE_SCOPE("SolveVRP");
+	BeginRun();
+	while (RunGenerations(mIterations))
 	{
-		for (int i = 0; i < mNumCities; i++)
+	}
+}
+
+void GeneticAlgorithm::BeginRun()
+{
+	PROFILE_SCOPE("BeginRun");
+	mStart = mRunStart != std::chrono::steady_clock::time_point::min() ? mRunStart : std::chrono::steady_clock::now();
+	mTimeToTarget = -1.0;
+	mGenerations = 0;
+	mStagnation = 0;
+	mPendingExchange = 0;
+
+	// Allocate both generations and the crossover buffers of every island thread once, they are reused every iteration
+	mPopulation.Resize(mPopulationSize, mRouteSize, EvaluationCacheSize());
+	mNextPopulation.Resize(mPopulationSize, mRouteSize, EvaluationCacheSize());
+	mWorkspaces.resize(std::max(mIslandThreads, 1));
+	for (Workspace& workspace : mWorkspaces)
+	{
+		workspace.Father.resize(mRouteSize);
+		workspace.Mother.resize(mRouteSize);
+		workspace.InversionFather.resize(mRouteSize);
+		workspace.InversionMother.resize(mRouteSize);
+		workspace.InversionChild.resize(mRouteSize);
+		workspace.InversionVerify.resize(mRouteSize);
+		workspace.Fenwick.resize(mRouteSize + 1);
+		workspace.Positions.resize(mRouteSize);
+		if (mLocalSearchRate > 0.0)
 		{
-			delete[] mDistances[i];
+			workspace.Search.Setup(*this);
 		}
-		delete[] mDistances;
 	}
+	if (mBestSolution == nullptr)
+	{
+		mBestSolution = new int[mRouteSize];
+	}
+
+	// Initialization and construction run on the island threads, the generations set their team size themselves
+	const int maxThreads = omp_get_max_threads();
+	if (mIslandThreads > 1)
+	{
+		omp_set_num_threads(mIslandThreads);
+	}
+
+	InitPopulation(mPopulation);
+
+	EvaluatePopulation(mPopulation);
+	SaveBest(mPopulation, true);	// Save best from initial population
+	omp_set_num_threads(maxThreads);
 }
 
-void GeneticAlgorithm::SolveVRP()
+bool GeneticAlgorithm::RunGenerations(int count)
 {
-	int** population = InitPopulation();
+	bool running = AdvanceRun(count);
+	if (!running)
+	{
+		EndRun();
+	}
+	return running;
+}
 
-	int* routeLength = new int[mPopulationSize];
-	for (int i = 0; i < mPopulationSize; i++)
+void GeneticAlgorithm::EndRun()
+{
+	if (mMigration != nullptr)
 	{
-		routeLength[i] = EvaluateFitness(population[i]);
+		mMigration->Leave(mIsland);
 	}
-	mBestSolution = SaveBest(population, routeLength);	// Save best from initial population
+	mPendingExchange = 0;
+}
 
-	for (int j = 0; j < mIterations; j++)
+bool GeneticAlgorithm::AdvanceRun(int count)
+{
+	for (int k = 0; k < count; k++)
 	{
-		population = CreateNewGeneration(population, routeLength);
-		population = Mutate(population);
-		int* routeLength = new int[mPopulationSize];
-		for (int i = 0; i < mPopulationSize; i++)
+		PROFILE_SCOPE("Generation");
+		const int j = mGenerations;
+		if (j >= mIterations)
 		{
-			routeLength[i] = EvaluateFitness(population[i]);
+			return false;
 		}
 
-		int* temp = SaveBest(population, routeLength);	// Save the best of each iteration
-		if (j == 0 || EvaluateFitness(temp) < EvaluateFitness(mBestSolution))
+		// Another island reached the target (or the time is up)
+		if (IsStopped())
 		{
-			delete[] mBestSolution;
-			mBestSolution = temp;
+			return false;
 		}
-		else
+
+		// Synchronous migration: the migrants of the last exchange come in before the next generation, so they always
+		// arrive at the same generation. Until every neighbour has sent them the island waits, the caller can run other
+		// islands meanwhile
+		if (mPendingExchange > 0)
 		{
-			delete[] temp;
+			if (!Immigrate(mPopulation))
+			{
+				std::this_thread::yield();
+				return true;
+			}
+			if (SaveBest(mPopulation, false))
+			{
+				mStagnation = 0;
+			}
 		}
-		delete[] routeLength;
-	}
 
-	delete[] routeLength;
-	for (int i = 0; i < mPopulationSize; i++)
-	{
-		delete[] population[i];
-	}
-	delete[] population;
-}
+		CreateNewGeneration(mPopulation, mNextPopulation);
+		mPopulation.Swap(mNextPopulation);
+		Mutate(mPopulation);
+		EvaluatePopulation(mPopulation);
 
-bool GeneticAlgorithm::ReadFile(std::string path, bool calculateMissingRoutes)
-{
-	std::vector<Road> roads;
-	std::map<std::string, int> cityMap;
-	int cityCounter = 0;
+		// Otherwise migrants replace the worst individuals whenever they arrived, a fast island never waits
+		if (mMigration != nullptr && !mMigration->IsSynchronous())
+		{
+			Immigrate(mPopulation);
+		}
 
-	// Load important data from file
-	std::ifstream file(path);
-	std::string line;
-	while (getline(file, line))
-	{
-		size_t commentIndex = line.find('%');
-		if (commentIndex == 0U)	// Check if a comment exists in this line
+		bool improved = SaveBest(mPopulation, j == 0);	// Save the best of each iteration
+		mStagnation = improved ? 0 : mStagnation + 1;
+		mGenerations++;
+
+		if (mMigration != nullptr && mMigration->Interval() > 0 && (j + 1) % mMigration->Interval() == 0)
 		{
-			continue;
+			Emigrate(mPopulation);
 		}
 
-		if (Util::StartsWith(line, "road"))		// Load road if line starts with road
+		// Stop criteria
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+		if (mTargetFitness >= 0 && mBestFitness <= mTargetFitness)
 		{
-			size_t end = std::string::npos;
-			size_t offset = 0U;
-			while ((end = line.find('.', offset)) != std::string::npos	// Find end of road, offset is used if multiple roads are in one line
-				   && end < commentIndex								// Check if found end is not after comment
-				   )
+			// Good enough, stop all islands
+			mTimeToTarget = elapsed;
+			if (mStop != nullptr)
 			{
-				roads.push_back(Road());
-				roads[roads.size() - 1].Parse(line.substr(offset, end));	// Parse road string
-				offset = end + 1;
+				mStop->store(true, std::memory_order_relaxed);
 			}
+			return false;
 		}
-		else if (Util::StartsWith(line, "city"))	// Load city
+		if (mTimeLimit > 0.0 && elapsed >= mTimeLimit)
 		{
-			size_t end = std::string::npos;
-			size_t offset = 0U;
-			while ((end = line.find(").", offset)) != std::string::npos	// Find end of road, offset is used if multiple roads are in one line
-				   && end < commentIndex								// Check if found end is not after comment
-				   )
+			if (mStop != nullptr)
 			{
-				mCities.push_back(City());
-				mCities[mCities.size() - 1].Parse(line.substr(offset, end));	// Parse city string
-				offset = end + 1;
-				cityMap.insert(std::make_pair(mCities[mCities.size() - 1].Name, cityCounter++));
+				mStop->store(true, std::memory_order_relaxed);
 			}
+			return false;
+		}
+		if (mMaxStagnation > 0 && mStagnation >= mMaxStagnation)
+		{
+			// Only this island converged, the others keep going
+			return false;
 		}
 	}
-	file.close();
+	return mGenerations < mIterations;
+}
 
-	// Save variables
-	mNumCities = cityCounter;
-	mRouteSize = mNumCities + (sVehicles - 1);
+// Sends copies of the best individuals to the neighbour islands. With synchronous migration the neighbours wait for
+// the packet even if it is empty
+void GeneticAlgorithm::Emigrate(const Population& population)
+{
+	PROFILE_SCOPE("Emigrate");
+	int numMigrants = std::max(std::min(mMigration->NumMigrants(), mPopulationSize), 0);
+	if (numMigrants == 0 && !mMigration->IsSynchronous())
+	{
+		return;
+	}
 
-	// Created adj. matrix
-	mDistances = new int* [mNumCities];
-	for (int i = 0; i < mNumCities; i++)
+	const int* fitness = population.Fitness();
+	mOrder.resize(mPopulationSize);
+	std::iota(mOrder.begin(), mOrder.end(), 0);
+	std::partial_sort(mOrder.begin(), mOrder.begin() + numMigrants, mOrder.end(), [fitness](int a, int b) { return fitness[a] < fitness[b]; });
+
+	MigrationHub::Packet packet;
+	packet.Count = numMigrants;
+	packet.Exchange = mGenerations / mMigration->Interval();
+	packet.Routes.resize(static_cast<size_t>(numMigrants) * mRouteSize);
+	for (int i = 0; i < numMigrants; i++)
 	{
-		mDistances[i] = new int[mNumCities];
-		for (int j = 0; j < mNumCities; j++)
+		std::copy(population[mOrder[i]], population[mOrder[i]] + mRouteSize, packet.Routes.begin() + static_cast<size_t>(i) * mRouteSize);
+	}
+	mMigration->Send(mIsland, packet, mRandom);
+	mPendingExchange = mMigration->IsSynchronous() ? packet.Exchange : 0;
+}
+
+// Replaces the worst individuals with the migrants that arrived since the last call (synchronous: the migrants of the
+// pending exchange) and evaluates them. Returns false if nothing arrived (synchronous: not all neighbours have sent yet)
+bool GeneticAlgorithm::Immigrate(Population& population)
+{
+	PROFILE_SCOPE("Immigrate");
+	mInbox.clear();
+	if (mMigration->IsSynchronous())
+	{
+		if (!mMigration->Receive(mIsland, mPendingExchange, mInbox))
+		{
+			return false;
+		}
+		mPendingExchange = 0;
+	}
+	else if (!mMigration->Receive(mIsland, mInbox))
+	{
+		return false;
+	}
+
+	int numMigrants = 0;
+	for (const auto& packet : mInbox)
+	{
+		numMigrants += packet->Count;
+	}
+	// Never replace the better half, it is the parent pool of the next generation
+	numMigrants = std::min(numMigrants, mPopulationSize / 2);
+
+	const int* fitness = population.Fitness();
+	mOrder.resize(mPopulationSize);
+	std::iota(mOrder.begin(), mOrder.end(), 0);
+	std::partial_sort(mOrder.begin(), mOrder.begin() + numMigrants, mOrder.end(), [fitness](int a, int b) { return fitness[a] > fitness[b]; });
+
+	int replaced = 0;
+	for (const auto& packet : mInbox)
+	{
+		for (int i = 0; i < packet->Count && replaced < numMigrants; i++, replaced++)
 		{
-			mDistances[i][j] = i == j ? 0 : -1;
+			const int* migrant = packet->Routes.data() + static_cast<size_t>(i) * mRouteSize;
+			std::copy(migrant, migrant + mRouteSize, population[mOrder[replaced]]);
+			population.SetDirty(mOrder[replaced], true);
 		}
 	}
 
-	// Store values in adj. matrix
-	for (const auto& road : roads)
+	// Only the migrants need to be evaluated
+	if (replaced > 0)
 	{
-		int index1 = cityMap.at(road.City1);
-		int index2 = cityMap.at(road.City2);
+		EvaluatePopulation(population);
+	}
+	return true;
+}
 
-		mDistances[index1][index2] = road.Distance;
-		mDistances[index2][index1] = road.Distance;
+bool GeneticAlgorithm::ReadFile(std::string path, bool calculateMissingRoutes)
+{
+	PROFILE_SCOPE("ReadFile");
+
+	MappedFile input;
+	if (!input.Open(path, true))
+	{
+		std::cout << "Could not open " << path << std::endl;
+		return false;
 	}
 
-	// Calculate missing routes using a path finder
-	// Is done to have less work in crossover and mutate
-	if (calculateMissingRoutes)
+	// Cities and distances of an unchanged input come from the cache, the matrix is used in place
+	bool onTheFly = mMetric != DistanceOracle::Metric::Matrix;
+	uint64_t inputHash = Util::HashBytes(input.Data(), input.Size());
+	std::string cachePath = DistanceCache::CachePath(path, calculateMissingRoutes);
+	Instance instance;
+	bool cached = !onTheFly && mUseDistanceCache && DistanceCache::Load(cachePath, inputHash, calculateMissingRoutes, mVerifyDistanceCache, instance);
+	if (!cached)
 	{
-		// Create adjMatrix for PathFinder
-		PathFinder graph;
-		for (int i = 0; i < mNumCities; i++)
+		// Format is detected from the start of the file
+		const InstanceReader* reader = InstanceReader::Detect(input.Data(), input.Size());
+		if (reader == nullptr)
+		{
+			std::cout << "Unknown format of " << path << std::endl;
+			return false;
+		}
+		if (!reader->Read(input.Data(), input.Size(), !onTheFly, instance))
 		{
-			PathFinder::VPII a;
-			for (int j = 0; j < mNumCities; j++)
+			return false;
+		}
+
+		// Inputs without coordinates always come with a matrix
+		if (onTheFly && instance.Metric == DistanceOracle::Metric::Matrix)
+		{
+			std::cout << path << " has no coordinates, using the distance matrix" << std::endl;
+			onTheFly = false;
+		}
+
+		// Calculate missing routes using a path finder
+		// Is done to have less work in crossover and mutate
+		if (!onTheFly && calculateMissingRoutes && instance.HasMissingRoutes)
+		{
+			PROFILE_SCOPE("PathFinder");
+
+			// Create adjMatrix for PathFinder
+			const DistanceMatrix& roads = *instance.Distances;
+			PathFinder graph;
+			for (int i = 0; i < roads.Size(); i++)
 			{
-				if (mDistances[i][j] != 0 && mDistances[i][j] != -1)
+				PathFinder::VPII a;
+				for (int j = 0; j < roads.Size(); j++)
 				{
-					a.push_back(PathFinder::PII(j, mDistances[i][j]));
+					if (roads[i][j] != 0 && roads[i][j] != -1)
+					{
+						a.push_back(PathFinder::PII(j, roads[i][j]));
+					}
 				}
+				graph.Graph.push_back(a);
 			}
-			graph.Graph.push_back(a);
+
+			// Find and write shortest routes, rows are written in parallel
+			std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(roads.Size());
+			graph.AllShortestPaths(*distancePtr);
+			instance.Distances = distancePtr;
+			instance.HasMissingRoutes = false;
 		}
+	}
 
-		// Find and write shortest routes
-		for (int i = 0; i < mNumCities; i++)
+	// Save variables
+	mCities.swap(instance.Cities);
+	mTimeWindows.swap(instance.TimeWindows);
+	mCapacity = instance.Capacity;
+	mDepot = instance.Depot;
+	mNumCities = static_cast<int>(mCities.size());
+	mRouteSize = mNumCities + (mVehicles - 1);
+	if (mDepot >= mNumCities)
+	{
+		std::cout << "ERROR: Depot " << mDepot + 1 << " is not a city of the input" << std::endl;
+		return false;
+	}
+
+	// Flat copy of the demands for the fitness loops, empty disables the capacity term
+	mDemands.clear();
+	if (std::any_of(mCities.begin(), mCities.end(), [](const City& city) { return city.Demand != 0; }))
+	{
+		for (const City& city : mCities)
 		{
-			std::vector<int> dist = graph.ShortestPath(i);
-			for (int j = 0; j < mNumCities; j++)
-			{
-				mDistances[i][j] = dist[j];
-			}
+			mDemands.push_back(city.Demand);
 		}
 	}
+	if (mVehicles > mNumCities - 1)
+	{
+		// Every route needs at least one city besides the depot
+		std::cout << "ERROR: " << mVehicles << " vehicles need at least " << mVehicles + 1 << " cities, input has " << mNumCities << std::endl;
+		return false;
+	}
+
+	if (onTheFly)
+	{
+		// Distances are computed from the coordinates, memory stays O(N)
+		DistanceOracle::Metric metric = mMetric == DistanceOracle::Metric::Native ? instance.Metric : mMetric;
+		mDistances = std::make_shared<const DistanceOracle>(metric, instance.X, instance.Y);
+		UpdateNeighbourIndex(nullptr);
+		return true;
+	}
+
+	// Matrix is read-only from now on and shared between all copies
+	mDistances = std::make_shared<const DistanceOracle>(instance.Distances);
+	bool neighboursBuilt = UpdateNeighbourIndex(instance.Neighbours);
+	if (mUseDistanceCache && (!cached || neighboursBuilt))
+	{
+		instance.Cities = mCities;
+		instance.TimeWindows = mTimeWindows;
+		instance.Neighbours = mNeighbourIndex;
+		if (!DistanceCache::Save(cachePath, inputHash, calculateMissingRoutes, instance))
+		{
+			std::cout << "Could not write distance cache " << cachePath << std::endl;
+		}
+	}
+	return true;
+}
+
+// Takes over the cached neighbour index if it has the requested settings, otherwise builds it out of the distances.
+// The O(N^2) build is skipped if neither the local search nor the construction heuristics use the index.
+// Returns true if the index was built
+bool GeneticAlgorithm::UpdateNeighbourIndex(const std::shared_ptr<const NeighbourIndex>& cached)
+{
+	mNeighbourIndex = nullptr;
+	if (mNumNeighbours <= 0)
+	{
+		return false;
+	}
+	if (cached != nullptr && cached->K() == mNumNeighbours && cached->GetDirection() == mNeighbourDirection && cached->Size() == mNumCities)
+	{
+		mNeighbourIndex = cached;
+		return false;
+	}
+	if (mLocalSearchRate <= 0.0 && mHeuristicFraction <= 0.0)
+	{
+		return false;
+	}
+
+	PROFILE_SCOPE("NeighbourIndex");
+	auto index = std::make_shared<NeighbourIndex>();
+	index->Build(*mDistances, mNumNeighbours, mNeighbourDirection);
+	mNeighbourIndex = index;
 	return true;
 }
 
 void GeneticAlgorithm::PrintDistances() const
 {
 	// Print distances
+	const DistanceOracle& distances = *mDistances;
 	std::cout << "Distances:" << std::endl;
 	std::cout << "  \t";
 	for (int i = 0; i < mNumCities; i++)
@@ -272,7 +640,7 @@ void GeneticAlgorithm::PrintDistances() const
 		std::cout << char('A' + i) << " \t";
 		for (int j = 0; j < mNumCities; j++)
 		{
-			std::cout << std::to_string(mDistances[i][j]) << " \t";
+			std::cout << std::to_string(distances(i, j)) << " \t";
 		}
 		std::cout << std::endl;
 	}
@@ -288,7 +656,7 @@ void GeneticAlgorithm::PrintCities() const
 	}
 }
 
-bool GeneticAlgorithm::ValidateRoute(int* route, bool assertOnError) const
+bool GeneticAlgorithm::ValidateRoute(const int* route, bool assertOnError) const
 {
 	// Is used to find invalid routes
 
@@ -363,9 +731,9 @@ bool GeneticAlgorithm::ValidateRoute(int* route, bool assertOnError) const
 		}
 	}
 
-	if (numBlanks != sVehicles - 1)
+	if (numBlanks != mVehicles - 1)
 	{
-		std::cout << "ERROR: Number of blanks does not match! Expected: " << std::to_string(sVehicles - 1) << ", Actual: " << std::to_string(numBlanks) << std::endl;
+		std::cout << "ERROR: Number of blanks does not match! Expected: " << std::to_string(mVehicles - 1) << ", Actual: " << std::to_string(numBlanks) << std::endl;
 
 		assert(!assertOnError);
 		return false;
@@ -373,95 +741,540 @@ bool GeneticAlgorithm::ValidateRoute(int* route, bool assertOnError) const
 	return true;
 }
 
-int** GeneticAlgorithm::InitPopulation()
+void GeneticAlgorithm::InitPopulation(Population& population)
 {
-	int** population = new int*[mPopulationSize];
-	for (int i = 0; i < mPopulationSize; i++)
+	PROFILE_SCOPE("InitPopulation");
+
+	// The first individuals come from the construction heuristics, the others are random
+	const int seeded = SeedPopulation(population);
+	if (mRepresentation == Representation::GiantTour)
 	{
-		population[i] = new int[mRouteSize];
+		InitGiantTours(population, seeded);
+		return;
 	}
+
 	// std::vector<int>(baseStation|routeVehicle1|blank|routeVehicle2|blank|routeVehicle3|blank|routeVehicle4|blank|routeVehicle5|...)	-> https://www.researchgate.net/publication/220743156_Vehicle_Routing_Problem_Doing_It_The_Evolutionary_Way
 	// Creates valid population (valid: base station set & no route empty) - number of cities per route can vary (distance between 2 cities on two sides of the country can be bigger than the distance between 5 close cities -> let Darwin do his thing)
-	std::default_random_engine generator(std::random_device{}());
+	// Valid individuals are drawn directly (stars and bars): the depot is followed by a random permutation of the customers,
+	// and the blanks go into distinct gaps between two customers, chosen uniformly with Floyd's sampling. No draw is
+	// rejected, so this is O(N) per individual for every fleet size. Every individual has its own random stream, the
+	// rows are filled in parallel and don't depend on the number of threads
+	const int first = mDepot >= 0 ? 1 : 0;
+	const int gaps = mNumCities - 2;
+	const int blanks = mVehicles - 1;
+	std::vector<uint64_t> seeds(mPopulationSize - seeded);
+	for (uint64_t& seed : seeds)
+	{
+		seed = mRandom();
+	}
+
+#pragma omp parallel
+	{
+		std::vector<int> cities(mNumCities);
+		std::vector<char> blankAfter(std::max(gaps, 0));
+
+#pragma omp for
+		for (int i = seeded; i < mPopulationSize; i++)
+		{
+			Xoshiro256 random(seeds[i - seeded]);
+			std::iota(cities.begin(), cities.end(), 0);
+			if (mDepot >= 0)
+			{
+				std::swap(cities[0], cities[mDepot]);
+			}
+			std::shuffle(cities.begin() + first, cities.end(), random);
+
+			// Uniform subset of blanks gaps, gap g lies between the customers cities[g + 1] and cities[g + 2]
+			std::fill(blankAfter.begin(), blankAfter.end(), 0);
+			for (int j = gaps - blanks; j < gaps; j++)
+			{
+				std::uniform_int_distribution<int> distribution(0, j);
+				const int gap = distribution(random);
+				blankAfter[blankAfter[gap] ? j : gap] = 1;
+			}
+
+			int* individual = population[i];
+			int position = 0;
+			individual[position++] = cities[0];
+			for (int k = 1; k < mNumCities; k++)
+			{
+				individual[position++] = cities[k];
+				if (k <= gaps && blankAfter[k - 1])
+				{
+					individual[position++] = sBlank;
+				}
+			}
+			population.SetDirty(i, true);
+		}
+	}
+}
 
-	int city;
+// Evaluates all individuals that changed since their last evaluation
+void GeneticAlgorithm::EvaluatePopulation(Population& population) const
+{
+	(this->*mEvaluatePopulationKernel)(population);
+}
+
+int GeneticAlgorithm::EvaluateIndividual(const int* individual, int* cache) const
+{
+	return (this->*mEvaluateIndividualKernel)(individual, cache);
+}
+
+template<int K>
+void GeneticAlgorithm::EvaluatePopulationK(Population& population) const
+{
+	PROFILE_SCOPE("EvaluatePopulation");
+	int* fitness = population.Fitness();
+
+	// The batch kernels index the matrix with ints
+	const DistanceMatrix* matrix = mDistances->Matrix().get();
+	const bool batch = mBatchEvaluation && matrix != nullptr
+		&& static_cast<int64_t>(matrix->Size()) * matrix->Stride() <= static_cast<int64_t>(INT32_MAX);
+
+	// Scratch buffers of the kernels are thread_local, the island threads evaluate chunks of the population
+#pragma omp parallel for num_threads(mIslandThreads) schedule(dynamic, 64) if (mIslandThreads > 1)
 	for (int i = 0; i < mPopulationSize; i++)
 	{
-		// Add all cities to array
-		std::vector<int> place;
-		for (int k = 0; k < mNumCities; k++)
+		if (population.IsDirty(i))
 		{
-			place.push_back(k);
+			// Routes of the local search are kept, Split would cut the tour again
+			if (mRepresentation == Representation::GiantTour && !population.IsDecoded(i))
+			{
+				SplitIndividual(population[i]);
+			}
+			fitness[i] = batch ? EvaluateBatchK<K>(population[i], population.Cache(i), matrix->Data(), matrix->Stride())
+				: EvaluateIndividualK<K>(population[i], population.Cache(i));
+			population.SetDirty(i, false);
 		}
-		// Add blanks to array
-		for (int k = 0; k < sVehicles - 1; k++)
+	}
+}
+
+// Same result and cache as EvaluateIndividualK without branches in the loops over the chromosome: blanks are read as
+// the depot, so every edge is one gather from the matrix, and the route lengths and loads are sums between two blanks.
+// Individuals that EvaluateIndividualK rejects or can't cache (empty routes, blank at the end, wrong number of blanks)
+// are passed on to it
+template<int K>
+int GeneticAlgorithm::EvaluateBatchK(const int* individual, int* cache, const int* matrix, int stride) const
+{
+	static thread_local std::vector<int> values;
+	const int vehicles = K > 0 ? K : mVehicles;
+	int* routeLengths = cache + 1;
+	int* blanks = cache + 1 + vehicles;
+
+	if (individual[0] == sBlank || individual[1] == sBlank)
+	{
+		return EvaluateIndividualK<K>(individual, cache);
+	}
+
+	// Route r ends with the blank at blanks[r], the last one with the last position. A blank at the end, two blanks
+	// in a row or another number of blanks than vehicles - 1 are left to EvaluateIndividualK
+	const int* end = individual + mRouteSize;
+	const int* position = individual + 1;
+	for (int route = 0; route < vehicles - 1; route++)
+	{
+		position = std::find(position + 1, end, sBlank);
+		if (position >= end - 1 || position[1] == sBlank)
 		{
-			place.push_back(sBlank);
+			return EvaluateIndividualK<K>(individual, cache);
 		}
+		blanks[route] = static_cast<int>(position - individual);
+	}
+	if (std::find(position + 1, end, sBlank) != end)
+	{
+		return EvaluateIndividualK<K>(individual, cache);
+	}
 
-		// Swap cities and blanks randomly
-		int s = mNumCities + sVehicles - 1;
-		for (int j = 0; j < mNumCities + sVehicles - 1; j++)
+	// Route r has the edges behind the blank before it up to its own blank. The loop of EvaluateFitness stops before
+	// the last position, its edge only counts if a blank precedes it
+	values.resize(mRouteSize);
+	FitnessKernels::GatherEdges(matrix, stride, individual, mRouteSize, sBlank, values.data());
+	if (individual[mRouteSize - 2] != sBlank)
+	{
+		values[mRouteSize - 1] = 0;
+	}
+	int begin = 1;
+	for (int route = 0; route < vehicles; route++)
+	{
+		const int end = route < vehicles - 1 ? blanks[route] : mRouteSize - 1;
+		routeLengths[route] = FitnessKernels::Sum(values.data(), begin, end + 1);
+		begin = end + 1;
+	}
+	int fitness = RouteFitnessK<K>(routeLengths);
+
+	if (HasCapacity())
+	{
+		int* routeLoads = blanks + (vehicles - 1);
+		FitnessKernels::GatherDemands(mDemands.data(), individual, mRouteSize, sBlank, values.data());
+		begin = 1;
+		for (int route = 0; route < vehicles; route++)
 		{
-			std::uniform_int_distribution<int> distribution(0, s - 1);
+			const int end = route < vehicles - 1 ? blanks[route] : mRouteSize;
+			routeLoads[route] = FitnessKernels::Sum(values.data(), begin, end);
+			begin = end + 1;
+		}
+		fitness += CapacityPenaltyK<K>(routeLoads);
+	}
 
-			city = distribution(generator);
-			population[i][j] = place[city];
+	if (HasTimeWindows())
+	{
+		fitness += UpdateTimeWarpsK<K>(individual, cache) * mTimeWarpPenalty;
+	}
+
+	cache[0] = 1;
+	return fitness;
+}
+
+// Same result as EvaluateFitness, additionally stores the length and load of every route and the blank positions in the cache
+// K is the number of vehicles, 0 for the generic version that reads mVehicles
+template<int K>
+int GeneticAlgorithm::EvaluateIndividualK(const int* individual, int* cache) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int vehicles = K > 0 ? K : mVehicles;
+	int* blanks = cache + 1 + vehicles;
+
+	// Fixed fleet sizes sum up in a local array, the generic version directly in the cache
+	int localLengths[K > 0 ? K : 1];
+	int* routeLengths = K > 0 ? localLengths : cache + 1;
+
+	cache[0] = 0;
+	if (individual[0] == sBlank || individual[1] == sBlank)
+	{
+		return INT32_MAX;
+	}
 
-			//int temp = place[s - 1];
-			place[city] = place[s - 1];
-			place.pop_back();
-			s = s - 1;
+	// Coordinate metrics are symmetric: with blanks replaced by the depot, every distance the loop needs is the one
+	// between two neighbouring positions. They are computed in one vectorized batch
+	const int* neighbours = nullptr;
+	if (!distances.IsMatrix())
+	{
+		static thread_local std::vector<int> nodes;
+		static thread_local std::vector<int> lengths;
+		nodes.resize(mRouteSize);
+		lengths.resize(mRouteSize);
+		for (int i = 0; i < mRouteSize; i++)
+		{
+			nodes[i] = individual[i] == sBlank ? individual[0] : individual[i];
 		}
+		distances.Batch(nodes.data() + 1, nodes.data(), mRouteSize - 1, lengths.data() + 1);
+		neighbours = lengths.data();
+	}
 
-		// Check if no base station is set and if routes of first and last vehicle is empty
-		if (population[i][0] == sBlank || population[i][1] == sBlank || population[i][mRouteSize - 1] == sBlank)
+	std::fill(routeLengths, routeLengths + vehicles, 0);
+	int route = 0;
+	for (int i = 1; i < mRouteSize - 1; i++)
+	{
+		if (individual[i] != sBlank)
+		{
+			if (individual[i - 1] != sBlank)
+			{
+				routeLengths[route] += neighbours != nullptr ? neighbours[i] : distances(individual[i], individual[i - 1]);
+			}
+		}
+		else
 		{
-			// Reset loop and generate a new version for this individual
-			--i;
-			continue;
+			if (individual[i + 1] == sBlank)
+			{
+				return INT32_MAX;
+			}
+			if (route == vehicles - 1)
+			{
+				// More blanks than vehicles, can't be cached
+				return EvaluateFitness(individual);
+			}
+
+			// Previous element can't be a blank, two blanks in a row were already rejected
+			blanks[route] = i;
+			routeLengths[route] += neighbours != nullptr ? neighbours[i] : distances(individual[i - 1], individual[0]);
+			route++;
+			routeLengths[route] += neighbours != nullptr ? neighbours[i + 1] : distances(individual[0], individual[i + 1]);
 		}
+	}
 
-		bool hasEmptyRoutes = false;
-		// Check if there are blanks next to each other
-		for (int j = 1; j < mRouteSize; j++)// Start on second index to prevent out of bounds when checking previous element
+	if (route != vehicles - 1)
+	{
+		// Blank on the last position is not counted by EvaluateFitness, can't be cached
+		return EvaluateFitness(individual);
+	}
+
+	if (K > 0)
+	{
+		std::copy(routeLengths, routeLengths + vehicles, cache + 1);
+	}
+	int fitness = RouteFitnessK<K>(routeLengths);
+
+	if (HasCapacity())
+	{
+		// Load of every route, the last city is not visited by the distance loop
+		int* routeLoads = blanks + (vehicles - 1);
+		std::fill(routeLoads, routeLoads + vehicles, 0);
+		route = 0;
+		for (int i = 1; i < mRouteSize; i++)
 		{
-			// If both previous and current element are blanks
-			if (population[i][j] == sBlank && population[i][j - 1] == sBlank)
+			if (individual[i] == sBlank)
 			{
-				// Mark as invalid and kill this loop
-				hasEmptyRoutes = true;
-				break;
+				route++;
 			}
+			else
+			{
+				routeLoads[route] += mDemands[individual[i]];
+			}
+		}
+		fitness += CapacityPenaltyK<K>(routeLoads);
+	}
+
+	if (HasTimeWindows())
+	{
+		fitness += UpdateTimeWarpsK<K>(individual, cache) * mTimeWarpPenalty;
+	}
+
+	cache[0] = 1;
+	return fitness;
+}
+
+// Fitness out of the route length of every vehicle, same calculation as in EvaluateFitness
+template<int K>
+int GeneticAlgorithm::RouteFitnessK(const int* routeLengths) const
+{
+	const int vehicles = K > 0 ? K : mVehicles;
+
+	int routeLength = 0;
+	for (int i = 0; i < vehicles; i++)
+	{
+		routeLength += routeLengths[i];
+	}
+
+	int averageTruckDistance = routeLength / vehicles;
+	int distanceDifference = 0;
+	for (int i = 0; i < vehicles; i++)
+	{
+		distanceDifference += std::abs(averageTruckDistance - routeLengths[i]);
+	}
+	int averageDistanceDifference = distanceDifference / vehicles;
+	int addCorrected = averageDistanceDifference * 10;
+
+	// Weights 0.3 and 0.7 of EvaluateFitness in fixed point, bit-identical to its float result
+	return FitnessKernels::WeightedFitness(routeLength, addCorrected);
+}
+
+// Penalty for the load above the capacity of every vehicle
+template<int K>
+int GeneticAlgorithm::CapacityPenaltyK(const int* routeLoads) const
+{
+	const int vehicles = K > 0 ? K : mVehicles;
+
+	int excess = 0;
+	for (int i = 0; i < vehicles; i++)
+	{
+		excess += std::max(0, routeLoads[i] - mCapacity);
+	}
+	return excess * mCapacityPenalty;
+}
+
+// Route that position i belongs to, a blank belongs to the route it ends
+template<int K>
+int GeneticAlgorithm::RouteIndexK(const int* blanks, int i) const
+{
+	const int vehicles = K > 0 ? K : mVehicles;
+
+	int route = 0;
+	while (route < vehicles - 1 && blanks[route] < i)
+	{
+		route++;
+	}
+	return route;
+}
+
+// Adds (sign = 1) or removes (sign = -1) the distances step i of the EvaluateFitness loop counts to the cached route lengths
+template<int K>
+void GeneticAlgorithm::AccumulateStep(const int* individual, const int* blanks, int i, int sign, int* routeLengths) const
+{
+	const DistanceOracle& distances = *mDistances;
+	int route = RouteIndexK<K>(blanks, i);
+
+	if (individual[i] != sBlank)
+	{
+		if (individual[i - 1] != sBlank)
+		{
+			routeLengths[route] += sign * distances(individual[i], individual[i - 1]);
+		}
+	}
+	else if (individual[i - 1] != sBlank && individual[i + 1] != sBlank)
+	{
+		routeLengths[route] += sign * distances(individual[i - 1], individual[0]);
+		routeLengths[route + 1] += sign * distances(individual[0], individual[i + 1]);
+	}
+}
+
+// Swaps two cities (no blanks, not the depot) and updates the cached route lengths, loads and time warps in O(1)
+// Only the loop steps of EvaluateFitness that read one of the two positions change
+template<int K>
+int GeneticAlgorithm::SwapWithDelta(int* individual, int* cache, int first, int second) const
+{
+	const int vehicles = K > 0 ? K : mVehicles;
+	int* routeLengths = cache + 1;
+	const int* blanks = routeLengths + vehicles;
+	int* routeLoads = routeLengths + vehicles + (vehicles - 1);
+
+	// The two customers exchange their routes, only the loads of these routes change
+	bool capacity = HasCapacity();
+	if (capacity)
+	{
+		int firstRoute = RouteIndexK<K>(blanks, first);
+		int secondRoute = RouteIndexK<K>(blanks, second);
+		int difference = mDemands[individual[second]] - mDemands[individual[first]];
+		routeLoads[firstRoute] += difference;
+		routeLoads[secondRoute] -= difference;
+	}
+	bool timeWindows = HasTimeWindows();
+	if (timeWindows)
+	{
+		SwapTimeWarpK<K>(individual, cache, first, second);
+	}
+
+	int steps[] = { first - 1, first, first + 1, second - 1, second, second + 1 };
+	std::sort(steps, steps + 6);
+	int numSteps = static_cast<int>(std::unique(steps, steps + 6) - steps);
+
+	for (int k = 0; k < numSteps; k++)
+	{
+		if (steps[k] >= 1 && steps[k] < mRouteSize - 1)
+		{
+			AccumulateStep<K>(individual, blanks, steps[k], -1, routeLengths);
+		}
+	}
+	std::swap(individual[first], individual[second]);
+	for (int k = 0; k < numSteps; k++)
+	{
+		if (steps[k] >= 1 && steps[k] < mRouteSize - 1)
+		{
+			AccumulateStep<K>(individual, blanks, steps[k], 1, routeLengths);
+		}
+	}
+
+	int fitness = RouteFitnessK<K>(routeLengths) + (capacity ? CapacityPenaltyK<K>(routeLoads) : 0);
+	if (timeWindows)
+	{
+		const int* routeWarps = cache + 3 * vehicles;
+		fitness += std::accumulate(routeWarps, routeWarps + vehicles, 0) * mTimeWarpPenalty;
+	}
+	return fitness;
+}
+
+// Stores the time warp of every route and returns their sum. With delta evaluation the time segments of all routes are
+// built as well, the swaps of the mutation use them
+template<int K>
+int GeneticAlgorithm::UpdateTimeWarpsK(const int* individual, int* cache) const
+{
+	const int vehicles = K > 0 ? K : mVehicles;
+	const int* blanks = cache + 1 + vehicles;
+	int* routeWarps = cache + 3 * vehicles;
+	int* scheduled = routeWarps + vehicles;
+	int* forward = scheduled + vehicles;
+	int* backward = forward + TimeSegment::sInts * mRouteSize;
+
+	int timeWarp = 0;
+	for (int route = 0; route < vehicles; route++)
+	{
+		int first = route == 0 ? 1 : blanks[route - 1] + 1;
+		int last = route == vehicles - 1 ? mRouteSize - 1 : blanks[route] - 1;
+		routeWarps[route] = mDeltaEvaluation ? BuildSchedule(individual, first, last, forward, backward) : RouteTimeWarp(individual, first, last);
+		scheduled[route] = mDeltaEvaluation ? 1 : 0;
+		timeWarp += routeWarps[route];
+	}
+	return timeWarp;
+}
+
+// Updates the time warp of the routes of two cities for swapping them, called before the swap.
+// Cities of different routes are evaluated in O(1) out of the forward and backward segments, cities of the same route
+// in O(second - first). The segments of both routes are out of date afterwards, a route is built again only when a
+// later swap touches it
+template<int K>
+void GeneticAlgorithm::SwapTimeWarpK(const int* individual, int* cache, int first, int second) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int vehicles = K > 0 ? K : mVehicles;
+	const int* blanks = cache + 1 + vehicles;
+	int* routeWarps = cache + 3 * vehicles;
+	int* scheduled = routeWarps + vehicles;
+	int* forward = scheduled + vehicles;
+	int* backward = forward + TimeSegment::sInts * mRouteSize;
+
+	if (first == second)
+	{
+		return;
+	}
+	if (first > second)
+	{
+		std::swap(first, second);
+	}
+
+	int firstRoute = RouteIndexK<K>(blanks, first);
+	int secondRoute = RouteIndexK<K>(blanks, second);
+	for (int route : { firstRoute, secondRoute })
+	{
+		if (scheduled[route] == 0)
+		{
+			int begin = route == 0 ? 1 : blanks[route - 1] + 1;
+			int last = route == vehicles - 1 ? mRouteSize - 1 : blanks[route] - 1;
+			BuildSchedule(individual, begin, last, forward, backward);
+			scheduled[route] = 1;
 		}
+	}
+
+	// City at position i, the depot for a blank and the end of the chromosome
+	auto node = [&](int i) { return i == mRouteSize || individual[i] == sBlank ? individual[0] : individual[i]; };
 
-		if (hasEmptyRoutes)
+	int firstCity = individual[first];
+	int secondCity = individual[second];
+	TimeSegment firstVisit = TimeSegment::Visit(mTimeWindows[firstCity]);
+	TimeSegment secondVisit = TimeSegment::Visit(mTimeWindows[secondCity]);
+	if (firstRoute != secondRoute)
+	{
+		routeWarps[firstRoute] = Prefix(individual, forward, first - 1)
+			.Then(secondVisit, distances(node(first - 1), secondCity))
+			.Then(Suffix(individual, backward, first + 1), distances(secondCity, node(first + 1))).TimeWarp;
+		routeWarps[secondRoute] = Prefix(individual, forward, second - 1)
+			.Then(firstVisit, distances(node(second - 1), firstCity))
+			.Then(Suffix(individual, backward, second + 1), distances(firstCity, node(second + 1))).TimeWarp;
+	}
+	else
+	{
+		TimeSegment segment = Prefix(individual, forward, first - 1).Then(secondVisit, distances(node(first - 1), secondCity));
+		int previous = secondCity;
+		for (int i = first + 1; i < second; i++)
 		{
-			// Reset loop and generate a new version for this individual
-			--i;
-			continue;
+			segment = segment.Then(TimeSegment::Visit(mTimeWindows[individual[i]]), distances(previous, individual[i]));
+			previous = individual[i];
 		}
+		segment = segment.Then(firstVisit, distances(previous, firstCity));
+		routeWarps[firstRoute] = segment.Then(Suffix(individual, backward, second + 1), distances(firstCity, node(second + 1))).TimeWarp;
 	}
-
-	return population;
+	scheduled[firstRoute] = 0;
+	scheduled[secondRoute] = 0;
 }
 
 //Calculates the Fitness of a given Route with the overall Distance of this Route and the average difference in Distance between the Trucks.
 //These Values get multiplied by specific Fitness Weights and are added together. The smaller the resulting number, the better the given route.
 
-int GeneticAlgorithm::EvaluateFitness(int* populationRoute) const
+int GeneticAlgorithm::EvaluateFitness(const int* populationRoute) const
 {
+	PROFILE_SCOPE("EvaluateFitness");
 	//Check for invalid Route. Set to max Fitness value
 	if (populationRoute[0] == sBlank || populationRoute[1] == sBlank)
 	{
 		return INT32_MAX;
 	}
 
+	const DistanceOracle& distances = *mDistances;
+
 	//Weights for the Fitness Calculation
 	float weight1 = 0.3;	// Weight of overall distance
 	float weight2 = 0.7;	// Weight of average distance
 
-	std::vector<int> routeDistances;
+	// Can have more routes than vehicles, the buffer is reused
+	static thread_local std::vector<int> routeDistances;
+	routeDistances.clear();
 
 	int s = mRouteSize;
 	int routeLength = 0;
@@ -481,7 +1294,7 @@ int GeneticAlgorithm::EvaluateFitness(int* populationRoute) const
 		{
 			if (populationRoute[i - 1] != sBlank)
 			{
-				currentDistance = mDistances[populationRoute[i]][populationRoute[i - 1]];
+				currentDistance = distances(populationRoute[i], populationRoute[i - 1]);
 				//Add currently calculated Distance to the Distance of all Routs together
 				routeLength += currentDistance;
 				//Add currently calculated Distance to the Distance for this Route
@@ -500,14 +1313,14 @@ int GeneticAlgorithm::EvaluateFitness(int* populationRoute) const
 			if (populationRoute[i - 1] != sBlank && populationRoute[i + 1] != sBlank)
 			{
 				//Calculate the Distance back to the Start
-				currentDistance = mDistances[populationRoute[i - 1]][populationRoute[0]];
+				currentDistance = distances(populationRoute[i - 1], populationRoute[0]);
 				routeLength += currentDistance;
 				routePartLength += currentDistance;
 
 				routeDistances.push_back(routePartLength);
 
 				//Prepare for next Truck on this Route
-				currentDistance = mDistances[populationRoute[0]][populationRoute[i + 1]];
+				currentDistance = distances(populationRoute[0], populationRoute[i + 1]);
 				routeLength += currentDistance;
 				routePartLength = currentDistance;
 			}
@@ -516,26 +1329,190 @@ int GeneticAlgorithm::EvaluateFitness(int* populationRoute) const
 	routeDistances.push_back(routePartLength);
 
 	//Calculate average difference in Distance between the Trucks
-	averageTruckDistance = routeLength / sVehicles;
+	averageTruckDistance = routeLength / mVehicles;
 	for (int distance : routeDistances)
 	{
 		distanceDifference += std::abs(averageTruckDistance - distance);
 	}
-	averageDistanceDifference = distanceDifference / sVehicles;
+	averageDistanceDifference = distanceDifference / mVehicles;
 
 	//Correct average Distance to be the same size as the route Length
 	addCorrected = averageDistanceDifference * 10;
 
-	return (weight1 * routeLength) + (weight2 * addCorrected);
+	int fitness = (weight1 * routeLength) + (weight2 * addCorrected);
+	if (HasCapacity())
+	{
+		fitness += CapacityExcess(populationRoute) * mCapacityPenalty;
+	}
+	if (HasTimeWindows())
+	{
+		fitness += TimeWarp(populationRoute) * mTimeWarpPenalty;
+	}
+	return fitness;
+}
+
+// Sum of the load above the capacity over all routes
+int GeneticAlgorithm::CapacityExcess(const int* route) const
+{
+	int excess = 0;
+	int load = 0;
+	for (int i = 1; i < mRouteSize; i++)
+	{
+		if (route[i] == sBlank)
+		{
+			excess += std::max(0, load - mCapacity);
+			load = 0;
+		}
+		else
+		{
+			load += mDemands[route[i]];
+		}
+	}
+	return excess + std::max(0, load - mCapacity);
+}
+
+// Sum of the time warp over all routes, every vehicle leaves the depot at its ready time.
+// Arriving early means waiting, arriving late is counted as time warp and the service starts at the due time
+int GeneticAlgorithm::TimeWarp(const int* route) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int depot = route[0];
+	const int start = mTimeWindows[depot].Ready + mTimeWindows[depot].Service;
+
+	int warp = 0;
+	int time = start;
+	int previous = depot;
+	for (int i = 1; i <= mRouteSize; i++)
+	{
+		// A blank and the end of the chromosome are a return to the depot
+		int city = i == mRouteSize || route[i] == sBlank ? depot : route[i];
+		const TimeWindow& window = mTimeWindows[city];
+		time = std::max(time + distances(previous, city), window.Ready);
+		if (time > window.Due)
+		{
+			warp += time - window.Due;
+			time = window.Due;
+		}
+		time = city == depot ? start : time + window.Service;
+		previous = city;
+	}
+	return warp;
+}
+
+// Time warp of the route between first and last, same simulation as TimeWarp
+int GeneticAlgorithm::RouteTimeWarp(const int* individual, int first, int last) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int depot = individual[0];
+
+	int warp = 0;
+	int time = mTimeWindows[depot].Ready + mTimeWindows[depot].Service;
+	int previous = depot;
+	for (int i = first; i <= last + 1; i++)
+	{
+		int city = i > last ? depot : individual[i];
+		const TimeWindow& window = mTimeWindows[city];
+		time = std::max(time + distances(previous, city), window.Ready);
+		if (time > window.Due)
+		{
+			warp += time - window.Due;
+			time = window.Due;
+		}
+		time += window.Service;
+		previous = city;
+	}
+	return warp;
+}
+
+int GeneticAlgorithm::BuildSchedule(const int* individual, int first, int last, int* forward, int* backward) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int depot = individual[0];
+	const TimeSegment depotVisit = TimeSegment::Visit(mTimeWindows[depot]);
+
+	TimeSegment segment = depotVisit;
+	int previous = depot;
+	for (int i = first; i <= last; i++)
+	{
+		segment = segment.Then(TimeSegment::Visit(mTimeWindows[individual[i]]), distances(previous, individual[i]));
+		segment.Store(forward + TimeSegment::sInts * i);
+		previous = individual[i];
+	}
+
+	segment = depotVisit;
+	int next = depot;
+	for (int i = last; i >= first; i--)
+	{
+		segment = TimeSegment::Visit(mTimeWindows[individual[i]]).Then(segment, distances(individual[i], next));
+		segment.Store(backward + TimeSegment::sInts * i);
+		next = individual[i];
+	}
+	return depotVisit.Then(segment, distances(depot, individual[first])).TimeWarp;
+}
+
+// Segment from the depot to position i, only the depot if i is the depot or a blank
+TimeSegment GeneticAlgorithm::Prefix(const int* individual, const int* forward, int i) const
+{
+	if (i == 0 || individual[i] == sBlank)
+	{
+		return TimeSegment::Visit(mTimeWindows[individual[0]]);
+	}
+	return TimeSegment::Load(forward + TimeSegment::sInts * i);
+}
+
+// Segment from position i back to the depot, only the depot behind the last position or on a blank
+TimeSegment GeneticAlgorithm::Suffix(const int* individual, const int* backward, int i) const
+{
+	if (i == mRouteSize || individual[i] == sBlank)
+	{
+		return TimeSegment::Visit(mTimeWindows[individual[0]]);
+	}
+	return TimeSegment::Load(backward + TimeSegment::sInts * i);
 }
 
 // Creates an array in which the number at a certain index indicates
 // how many numbers in the converted array (which were left of the number
 // of the index position) were greater than the number itself, formula source: https://user.ceng.metu.edu.tr/~ucoluk/research/publications/tspnew.pdf
-int* GeneticAlgorithm::createInversionSequence(int* individual)
+void GeneticAlgorithm::createInversionSequence(const int* individual, int* inversionSequence, Workspace& workspace)
+{
+	switch (mInversionMode)
+	{
+	case InversionMode::Legacy:
+		createInversionSequenceLegacy(individual, inversionSequence);
+		break;
+	case InversionMode::Verify:
+		createInversionSequenceLegacy(individual, workspace.InversionVerify.data());
+		createInversionSequenceFenwick(individual, inversionSequence, workspace);
+		VerifyInversion(workspace.InversionVerify.data(), inversionSequence, mRouteSize, "createInversionSequence");
+		break;
+	default:
+		createInversionSequenceFenwick(individual, inversionSequence, workspace);
+		break;
+	}
+}
+
+// Inverse function of "createInversionSequence()"
+void GeneticAlgorithm::recreateNumbers(const int* inversionSequence, int size, int* numbers, Workspace& workspace)
 {
-	int* inversionSequence = new int[mRouteSize];
+	switch (mInversionMode)
+	{
+	case InversionMode::Legacy:
+		recreateNumbersLegacy(inversionSequence, size, numbers, workspace);
+		break;
+	case InversionMode::Verify:
+		recreateNumbersLegacy(inversionSequence, size, workspace.InversionVerify.data(), workspace);
+		recreateNumbersFenwick(inversionSequence, size, numbers, workspace);
+		VerifyInversion(workspace.InversionVerify.data(), numbers, size, "recreateNumbers");
+		break;
+	default:
+		recreateNumbersFenwick(inversionSequence, size, numbers, workspace);
+		break;
+	}
+}
 
+// O(n^2) reference implementation, scans the individual once for every number
+void GeneticAlgorithm::createInversionSequenceLegacy(const int* individual, int* inversionSequence) const
+{
 	for (int i = 0; i < mRouteSize; i++)
 	{
 		int counter = 0;
@@ -550,15 +1527,12 @@ int* GeneticAlgorithm::createInversionSequence(int* individual)
 		}
 		inversionSequence[i] = counter;
 	}
-
-	return inversionSequence;
 }
 
-// Inverse function of "createInversionSequence()"
-int* GeneticAlgorithm::recreateNumbers(int* inversionSequence, int size)
+// O(n^2) reference implementation, shifts all following positions for every inserted number
+void GeneticAlgorithm::recreateNumbersLegacy(const int* inversionSequence, int size, int* numbers, Workspace& workspace)
 {
-	int* positions = new int[size];
-	int* square = new int[size];
+	int* positions = workspace.Positions.data();
 
 	for (int i = (size - 1); i >= 0; i--)
 	{
@@ -580,19 +1554,116 @@ int* GeneticAlgorithm::recreateNumbers(int* inversionSequence, int size)
 	for (int i = 0; i < size; i++)
 	{
 		int insertPosition = positions[i];
-		square[insertPosition] = (i + 1);
+		numbers[insertPosition] = (i + 1);
 	}
+}
+
+// O(n log n) version of createInversionSequenceLegacy
+// Walks the individual once, a Fenwick tree over the values counts how many smaller or equal numbers were already seen
+void GeneticAlgorithm::createInversionSequenceFenwick(const int* individual, int* inversionSequence, Workspace& workspace)
+{
+	int* tree = workspace.Fenwick.data();
+	std::fill(tree, tree + mRouteSize + 1, 0);
+	std::fill(inversionSequence, inversionSequence + mRouteSize, 0);
+
+	for (int j = 0; j < mRouteSize; j++)
+	{
+		int value = individual[j];
+
+		// Number of values <= value left of position j
+		int smallerOrEqual = 0;
+		for (int k = value + 1; k > 0; k -= k & -k)
+		{
+			smallerOrEqual += tree[k];
+		}
 
-	delete[] positions;
+		// Number 0 has no slot in the sequence, index i belongs to number i + 1
+		if (value > 0)
+		{
+			inversionSequence[value - 1] = j - smallerOrEqual;
+		}
 
-	return square;
+		for (int k = value + 1; k <= mRouteSize; k += k & -k)
+		{
+			tree[k]++;
+		}
+	}
 }
 
-int* GeneticAlgorithm::Crossover(int* father, int* mother)
+// O(n log n) version of recreateNumbersLegacy
+// Numbers are placed in ascending order, every free slot left of a number will later be taken by a greater one,
+// so number i + 1 goes to the free slot with inversionSequence[i] free slots in front of it
+void GeneticAlgorithm::recreateNumbersFenwick(const int* inversionSequence, int size, int* numbers, Workspace& workspace)
 {
-	int s = mRouteSize;
+	int* tree = workspace.Fenwick.data();
+
+	// Every slot is free, build tree of counts in O(n)
+	for (int k = 1; k <= size; k++)
+	{
+		tree[k] = 1;
+	}
+	for (int k = 1; k <= size; k++)
+	{
+		int parent = k + (k & -k);
+		if (parent <= size)
+		{
+			tree[parent] += tree[k];
+		}
+	}
+
+	int highestBit = 1;
+	while (highestBit * 2 <= size)
+	{
+		highestBit *= 2;
+	}
+
+	for (int i = 0; i < size; i++)
+	{
+		// Binary descent to the (inversionSequence[i] + 1)-th free slot
+		int remaining = inversionSequence[i] + 1;
+		int position = 0;
+		for (int step = highestBit; step > 0; step /= 2)
+		{
+			if (position + step <= size && tree[position + step] < remaining)
+			{
+				position += step;
+				remaining -= tree[position];
+			}
+		}
+
+		numbers[position] = i + 1;
+
+		for (int k = position + 1; k <= size; k += k & -k)
+		{
+			tree[k]--;
+		}
+	}
+}
+
+void GeneticAlgorithm::VerifyInversion(const int* expected, const int* actual, int size, const std::string& function) const
+{
+	for (int i = 0; i < size; i++)
+	{
+		if (expected[i] != actual[i])
+		{
+			std::cout << "ERROR: " << function << " differs from legacy version at index " << std::to_string(i)
+				<< "! Expected: " << std::to_string(expected[i]) << ", Actual: " << std::to_string(actual[i]) << std::endl;
+			assert(false);
+			return;
+		}
+	}
+}
+
+void GeneticAlgorithm::Crossover(int* father, int* mother, int* child, Workspace& workspace, Xoshiro256& random)
+{
+	PROFILE_SCOPE("Crossover");
+	if (mRepresentation == Representation::GiantTour)
+	{
+		OrderCrossover(father, mother, child, workspace, random);
+		return;
+	}
 
-	int* child = nullptr;
+	int s = mRouteSize;
 
 	int fatherOffset = 0;
 	int motherOffset = 0;
@@ -619,33 +1690,28 @@ int* GeneticAlgorithm::Crossover(int* father, int* mother)
 	}
 
 	//create inversion sequence of father
-	int* inversionSequenceP1;
-	inversionSequenceP1 = createInversionSequence(father);
+	int* inversionSequenceP1 = workspace.InversionFather.data();
+	createInversionSequence(father, inversionSequenceP1, workspace);
 
 	//create inversion sequence of mother
-	int* inversionSequenceP2;
-	inversionSequenceP2 = createInversionSequence(mother);
+	int* inversionSequenceP2 = workspace.InversionMother.data();
+	createInversionSequence(mother, inversionSequenceP2, workspace);
 
 	//crossover point somewhere between 20% and 80%
 	int min = s * 0.2;
 	int max = s * 0.8;
 
-	std::default_random_engine generator(std::random_device{}());
 	std::uniform_int_distribution<int> distribution(min, max);
 
-	int crossoverPoint = distribution(generator) + 1;
-	int* inversionSequenceChild = new int[s];
+	int crossoverPoint = distribution(random) + 1;
+	int* inversionSequenceChild = workspace.InversionChild.data();
 
 	//create child based on crossover point
 	std::copy(inversionSequenceP1, inversionSequenceP1 + crossoverPoint, inversionSequenceChild);
 	std::copy(inversionSequenceP2 + crossoverPoint, inversionSequenceP2 + s, inversionSequenceChild + crossoverPoint);
 
 	//create usable child sequence
-	child = recreateNumbers(inversionSequenceChild, s);
-
-	delete[] inversionSequenceP1;
-	delete[] inversionSequenceP2;
-	delete[] inversionSequenceChild;
+	recreateNumbers(inversionSequenceChild, s, child, workspace);
 
 	int reshuffleBlanks = 0;
 
@@ -657,7 +1723,7 @@ int* GeneticAlgorithm::Crossover(int* father, int* mother)
 		if (child[i] >= mNumCities)
 		{
 			child[i] = sBlank; //reset route delimiters to sBlank
-			if (child[i - 1] == sBlank || i < 2) //avoid empty routes
+			if (i < 2 || child[i - 1] == sBlank) //avoid empty routes
 			{
 				for (int j = i; j < childSize - 1; j++)
 				{
@@ -693,18 +1759,22 @@ int* GeneticAlgorithm::Crossover(int* father, int* mother)
 		i++;
 	}
 
-	//ValidateRoute(child, true);
+	// A fixed depot stays on the first position
+	if (mDepot >= 0 && child[0] != mDepot)
+	{
+		std::swap(child[0], *std::find(child + 1, child + mRouteSize, mDepot));
+	}
 
-	return child;
+	//ValidateRoute(child, true);
 }
 
 //sort the population based on the associated fitness values via quick sort
-void GeneticAlgorithm::sort(int** population, int* fitness, int l, int r)
+//only the row views are swapped, the chromosomes stay in place
+void GeneticAlgorithm::sort(Population& population, int l, int r)
 {
+	int* fitness = population.Fitness();
 	int i = l;
 	int j = r;
-	int bufferFitness;
-	int* bufferPopulation;
 	int pivot = fitness[(l + r) / 2];
 	while (i <= j) {
 		while (fitness[i] < pivot)
@@ -718,76 +1788,101 @@ void GeneticAlgorithm::sort(int** population, int* fitness, int l, int r)
 
 		if (i <= j)
 		{
-			bufferFitness = fitness[i];
-			fitness[i] = fitness[j];
-			fitness[j] = bufferFitness;
-			bufferPopulation = population[i];
-			population[i] = population[j];
-			population[j] = bufferPopulation;
+			population.SwapRows(i, j);
 			i++;
 			j--;
 		}
 	}
 	if (l < j)
-		sort(population, fitness, l, j);
+		sort(population, l, j);
 	if (i < r)
-		sort(population, fitness, i, r);
+		sort(population, i, r);
 }
 
-int** GeneticAlgorithm::CreateNewGeneration(int** population, int* fitness)
+// With mIslandThreads > 1 the sort stays sequential, every offspring is bred with its own random stream in parallel
+void GeneticAlgorithm::CreateNewGeneration(Population& population, Population& newPopulation)
 {
-	//set the random generator to pick only from the better half of the population
-	std::default_random_engine generator(std::random_device{}());
-	std::uniform_int_distribution<int> distribution(0, mPopulationSize/2);
+	PROFILE_SCOPE("CreateNewGeneration");
 
 	//sort the population
-	sort(population, fitness, 0, mPopulationSize - 1);
-
-	int** new_population = new int* [mPopulationSize];
-	for (int i = 0; i < mPopulationSize; i++)
 	{
-		new_population[i] = new int[mRouteSize];
+		PROFILE_SCOPE("sort");
+		sort(population, 0, mPopulationSize - 1);
 	}
 
-	for (int i = 0; i < mPopulationSize / 2; i++) //take fathers and mothers from the better half of the population
+	ForEachIndividual(mPopulationSize / 2, [&](int i, Workspace& workspace, Xoshiro256& random)
 	{
-		int randomNum1 = distribution(generator);
-		int randomNum2 = distribution(generator);
-		if (randomNum1 == randomNum2)
-		{
-			i--;
-			continue;
-		}
+		Breed(population, newPopulation, i, workspace, random);
+	});
+}
+
+// Takes over individual i of the better half and writes a child of two of its members to i + mPopulationSize / 2
+void GeneticAlgorithm::Breed(Population& population, Population& newPopulation, int i, Workspace& workspace, Xoshiro256& random)
+{
+	//pick only from the better half of the population
+	std::uniform_int_distribution<int> distribution(0, mPopulationSize/2);
+	std::uniform_real_distribution<double> chance(0, 1);
 
-		std::copy(population[i], population[i] + mRouteSize, new_population[i]);
+	int randomNum1;
+	int randomNum2;
+	do
+	{
+		randomNum1 = distribution(random);
+		randomNum2 = distribution(random);
+	} while (randomNum1 == randomNum2);
 
-		//create father sequence
-		int* father = new int[mRouteSize];
-		std::copy(population[randomNum1], population[randomNum1] + mRouteSize, father);
+	//take over the better half including its fitness, no need to evaluate it again
+	newPopulation.CopyRow(population, i, i);
 
-		//create mother sequence
-		int* mother = new int[mRouteSize];
-		std::copy(population[randomNum2], population[randomNum2] + mRouteSize, mother);
+	//create father sequence
+	int* father = workspace.Father.data();
+	std::copy(population[randomNum1], population[randomNum1] + mRouteSize, father);
 
-		//get child sequence
-		int* child = Crossover(father, mother);
+	//create mother sequence
+	int* mother = workspace.Mother.data();
+	std::copy(population[randomNum2], population[randomNum2] + mRouteSize, mother);
 
-		delete[] new_population[i + mPopulationSize / 2];
-		new_population[i + mPopulationSize / 2] = child;
+	//write child sequence directly into the new generation
+	int* child = newPopulation[i + mPopulationSize / 2];
+	Crossover(father, mother, child, workspace, random);
+	newPopulation.SetDirty(i + mPopulationSize / 2, true);
 
-		delete[] father;
-		delete[] mother;
+	//memetic step, the local search improves the child before it is evaluated
+	if (mLocalSearchRate > 0.0 && chance(random) < mLocalSearchRate)
+	{
+		// A giant tour is cut into routes first, the local search moves customers between routes
+		if (mRepresentation == Representation::GiantTour)
+		{
+			SplitIndividual(child);
+			newPopulation.SetDecoded(i + mPopulationSize / 2, true);
+		}
+		workspace.Search.Improve(child, random);
 	}
-	for (int i = 0; i < mPopulationSize; i++)
+}
+
+template<typename Body>
+void GeneticAlgorithm::ForEachIndividual(int count, Body body)
+{
+	mSeeds.resize(std::max(count, 0));
+	for (uint64_t& seed : mSeeds)
 	{
-		delete[] population[i];
+		seed = mRandom();
 	}
-	delete[] population;
 
-	return new_population;
+#pragma omp parallel num_threads(mIslandThreads) if (mIslandThreads > 1)
+	{
+		Workspace& workspace = mWorkspaces[omp_get_thread_num()];
+
+#pragma omp for schedule(dynamic, 16)
+		for (int i = 0; i < count; i++)
+		{
+			Xoshiro256 random(mSeeds[i]);
+			body(i, workspace, random);
+		}
+	}
 }
 
-bool GeneticAlgorithm::CheckSwap(int* route, int first, int second) const
+bool GeneticAlgorithm::CheckSwap(const int* route, int first, int second) const
 {
 	if (route[second] == sBlank)
 	{
@@ -803,45 +1898,231 @@ bool GeneticAlgorithm::CheckSwap(int* route, int first, int second) const
 	return true;
 }
 
-int** GeneticAlgorithm::Mutate(int** population)
+void GeneticAlgorithm::Mutate(Population& population)
+{
+	if (mRepresentation == Representation::GiantTour)
+	{
+		MutateGiantTours(population);
+		return;
+	}
+	(this->*mMutateKernel)(population);
+}
+
+template<int K>
+void GeneticAlgorithm::MutateK(Population& population)
+{
+	PROFILE_SCOPE("Mutate");
+	// Number of mutation attempts has always been the route size, it must not exceed the population on large instances
+	int size = std::min(mRouteSize, mPopulationSize);
+	ForEachIndividual(size, [&](int i, Workspace&, Xoshiro256& random)
+	{
+		MutateIndividualK<K>(population, i, random);
+	});
+}
+
+template<int K>
+void GeneticAlgorithm::MutateIndividualK(Population& population, int i, Xoshiro256& random)
 {
 	// Mutation-Function
-	std::default_random_engine generator(std::random_device{}());
 	std::uniform_real_distribution<double> dis(0, 1);
-	// Maximum Array Size = numCities + 4 blanks (to separate the 5 vehicles)
-	std::uniform_int_distribution<int> disInt(0, mNumCities + sVehicles - 2);
-	int size = mRouteSize;
-	for (int i = 0; i < size; i++)
+	// Maximum Array Size = numCities + 4 blanks (to separate the 5 vehicles), a fixed depot is never moved
+	std::uniform_int_distribution<int> disInt(mDepot >= 0 ? 1 : 0, mRouteSize - 1);
+	double r = dis(random);
+	if (r <= mMutationRate)
 	{
-		double r = dis(generator);
-		if (r <= mMutationRate)
+		int first, second;
+		first = disInt(random);
+		second = disInt(random);
+
+		// Don't swap the depot, the first or the last city with a blank
+		while (!CheckSwap(population[i], first, second))
 		{
-			int first, second;
-			first = disInt(generator);
-			second = disInt(generator);
+			second = disInt(random);
+		}
 
-			// Don't swap the depot, the first or the last city with a blank
-			while (!CheckSwap(population[i], first, second))
-			{
-				second = disInt(generator);
-			}
+		// Don't swap the depot, the first or the last city  with a blank
+		while (!CheckSwap(population[i], second, first))
+		{
+			first = disInt(random);
+		}
+		int* individual = population[i];
+		if (!mDeltaEvaluation || population.IsDirty(i) || population.Cache(i)[0] == 0
+			|| first == 0 || second == 0 || individual[first] == sBlank || individual[second] == sBlank)
+		{
+			// Moving the depot or a blank changes the route layout, evaluate the whole individual again
+			std::swap(individual[first], individual[second]);
+			population.SetDirty(i, true);
+		}
+		else
+		{
+			population.Fitness()[i] = SwapWithDelta<K>(individual, population.Cache(i), first, second);
+		}
+	}
+}
 
-			// Don't swap the depot, the first or the last city  with a blank
-			while (!CheckSwap(population[i], second, first))
-			{
-				first = disInt(generator);
-			}
-			std::swap(population[i][first], population[i][second]);
+// Builds the first mHeuristicFraction of the population with the construction heuristics, cycling through the methods.
+// Every individual has its own random stream, so the result does not depend on the number of threads.
+// Seeded individuals are in the separator form, a giant tour reads them as the tour of their routes
+int GeneticAlgorithm::SeedPopulation(Population& population)
+{
+	const int count = std::min(static_cast<int>(mPopulationSize * mHeuristicFraction), mPopulationSize);
+	if (count <= 0)
+	{
+		return 0;
+	}
+	PROFILE_SCOPE("SeedPopulation");
+
+	Construction construction;
+	construction.Setup(*this);
+	std::vector<uint64_t> seeds(count);
+	for (uint64_t& seed : seeds)
+	{
+		seed = mRandom();
+	}
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < count; i++)
+	{
+		Xoshiro256 random(seeds[i]);
+		construction.Build(static_cast<Construction::Method>(i % Construction::sNumMethods), random, population[i]);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		population.SetDirty(i, true);
+	}
+	return count;
+}
+
+// Random giant tours from individual begin on, a fixed depot stays on the first position
+void GeneticAlgorithm::InitGiantTours(Population& population, int begin)
+{
+	const int first = mDepot >= 0 ? 1 : 0;
+	for (int i = begin; i < mPopulationSize; i++)
+	{
+		int* individual = population[i];
+		std::iota(individual, individual + mNumCities, 0);
+		if (mDepot >= 0)
+		{
+			std::swap(individual[0], individual[mDepot]);
+		}
+		std::shuffle(individual + first, individual + mNumCities, mRandom);
+		std::fill(individual + mNumCities, individual + mRouteSize, sBlank);
+		population.SetDirty(i, true);
+	}
+}
+
+// Moves all blanks to the end, the cities keep their order
+void GeneticAlgorithm::CompactIndividual(int* individual) const
+{
+	std::fill(std::remove(individual, individual + mRouteSize, sBlank), individual + mRouteSize, sBlank);
+}
+
+// Cuts the giant tour into mVehicles routes with the least distance (plus capacity penalty) and writes them with blanks.
+// Time windows are not considered by Split, they are part of the fitness of the result
+void GeneticAlgorithm::SplitIndividual(int* individual) const
+{
+	PROFILE_SCOPE("Split");
+	static thread_local Split split;
+	static thread_local std::vector<int> tour;
+	static thread_local std::vector<int> routeEnds;
+
+	// Cities after the depot in visiting order, blanks of an earlier decoding are dropped
+	tour.clear();
+	for (int i = 1; i < mRouteSize; i++)
+	{
+		if (individual[i] != sBlank)
+		{
+			tour.push_back(individual[i]);
+		}
+	}
+	routeEnds.resize(mVehicles);
+	split.Decode(*mDistances, individual[0], tour.data(), static_cast<int>(tour.size()), mVehicles,
+		HasCapacity() ? mDemands.data() : nullptr, mCapacity, GetSplitPenalty(), routeEnds.data());
+
+	int position = 1;
+	int begin = 0;
+	for (int route = 0; route < mVehicles; route++)
+	{
+		if (route > 0)
+		{
+			individual[position++] = sBlank;
+		}
+		for (int k = begin; k < routeEnds[route]; k++)
+		{
+			individual[position++] = tour[k];
+		}
+		begin = routeEnds[route];
+	}
+}
+
+// Order crossover (OX) of two giant tours: the child takes a random slice of the father,
+// the other cities follow in the order of the mother starting behind the slice
+void GeneticAlgorithm::OrderCrossover(int* father, int* mother, int* child, Workspace& workspace, Xoshiro256& random)
+{
+	CompactIndividual(father);
+	CompactIndividual(mother);
+
+	// A fixed depot is on the first position of both parents
+	const int first = mDepot >= 0 ? 1 : 0;
+	const int size = mNumCities - first;
+	std::uniform_int_distribution<int> distribution(0, size - 1);
+	int begin = distribution(random);
+	int end = distribution(random);
+	if (begin > end)
+	{
+		std::swap(begin, end);
+	}
+
+	// Positions marks the cities of the slice
+	int* inSlice = workspace.Positions.data();
+	std::fill(inSlice, inSlice + mNumCities, 0);
+	child[0] = father[0];
+	for (int k = begin; k <= end; k++)
+	{
+		child[first + k] = father[first + k];
+		inSlice[father[first + k]] = 1;
+	}
+
+	int position = (end + 1) % size;
+	for (int k = 0; k < size; k++)
+	{
+		int city = mother[first + (end + 1 + k) % size];
+		if (inSlice[city] == 0)
+		{
+			child[first + position] = city;
+			position = (position + 1) % size;
 		}
 	}
+	std::fill(child + mNumCities, child + mRouteSize, sBlank);
+}
 
-	return population;
+// Swaps two random cities of the giant tour, Split finds the best routes for the new order
+void GeneticAlgorithm::MutateGiantTours(Population& population)
+{
+	PROFILE_SCOPE("Mutate");
+	int size = std::min(mRouteSize, mPopulationSize);
+	ForEachIndividual(size, [&](int i, Workspace&, Xoshiro256& random)
+	{
+		std::uniform_real_distribution<double> dis(0, 1);
+		std::uniform_int_distribution<int> disInt(mDepot >= 0 ? 1 : 0, mNumCities - 1);
+		if (dis(random) <= mMutationRate)
+		{
+			int* individual = population[i];
+			int first = disInt(random);
+			int second = disInt(random);
+			CompactIndividual(individual);
+			std::swap(individual[first], individual[second]);
+			population.SetDirty(i, true);
+		}
+	});
 }
 
-int* GeneticAlgorithm::SaveBest(int** population, int* fitness)
+bool GeneticAlgorithm::SaveBest(const Population& population, bool force)
 {
-	// Save the best solution of the current population
-	int* fitIter = fitness;
+	// Save the best solution of the current population if it is better than the best so far (or force is set)
+	// Compares the cached fitness values, the solution is only copied on improvement
+	const int* fitness = population.Fitness();
+	const int* fitIter = fitness;
 	int minFit = *fitIter;
 	int index = 0;
 	for (; fitIter != fitness + mPopulationSize; fitIter++)
@@ -852,9 +2133,29 @@ int* GeneticAlgorithm::SaveBest(int** population, int* fitness)
 			index = fitIter - fitness;
 		}
 	}
-	int* best = new int[mRouteSize];
-	std::copy(population[index], population[index] + mRouteSize, best);
-	return best;
+
+	if (!force && minFit >= mBestFitness)
+	{
+		return false;
+	}
+	std::copy(population[index], population[index] + mRouteSize, mBestSolution);
+	mBestFitness = minFit;
+	return true;
+}
+
+// Fitness out of the length, load and time warp of every route, same weighting as EvaluateFitness
+int GeneticAlgorithm::ScoreRoutes(const int* routeLengths, const int* routeLoads, const int* routeWarps) const
+{
+	int fitness = RouteFitnessK<0>(routeLengths);
+	if (HasCapacity())
+	{
+		fitness += CapacityPenaltyK<0>(routeLoads);
+	}
+	if (HasTimeWindows())
+	{
+		fitness += std::accumulate(routeWarps, routeWarps + mVehicles, 0) * mTimeWarpPenalty;
+	}
+	return fitness;
 }
 
 int* GeneticAlgorithm::GetBest() const
@@ -862,6 +2163,21 @@ int* GeneticAlgorithm::GetBest() const
 	return mBestSolution;
 }
 
+int GeneticAlgorithm::GetBestFitness() const
+{
+	return mBestFitness;
+}
+
+double GeneticAlgorithm::GetTimeToTarget() const
+{
+	return mTimeToTarget;
+}
+
+int GeneticAlgorithm::GetGenerations() const
+{
+	return mGenerations;
+}
+
 void GeneticAlgorithm::PrintOutput(int* solution) const
 {
 	// Output
@@ -873,11 +2189,14 @@ void GeneticAlgorithm::PrintOutput(int* solution) const
 
 	ValidateRoute(solution, false);
 
+	const DistanceOracle& distances = *mDistances;
+
 	std::string output = "Gesamtdistanz aller Fahrzeuge: ";
-	std::vector<std::string> vehicleStrings(sVehicles);
-	std::vector<int> vehicleDistances(sVehicles);
+	std::vector<std::string> vehicleStrings(mVehicles);
+	std::vector<int> vehicleDistances(mVehicles);
 	int completeDistance = 0;
 	int vehicleDistance = 0;
+	int vehicleLoad = 0;
 	int vehicleCounter = 0;
 
 	for (int i = 1; i <= mRouteSize; i++)
@@ -886,7 +2205,7 @@ void GeneticAlgorithm::PrintOutput(int* solution) const
 		{
 			if (vehicleDistance == 0)
 			{
-				if (vehicleCounter == sVehicles)
+				if (vehicleCounter == mVehicles)
 				{
 					break;
 				}
@@ -896,13 +2215,18 @@ void GeneticAlgorithm::PrintOutput(int* solution) const
 			else
 			{
 				// Build Output String (add vehicle details whenever a blank is discovered or the end is reached)
-				vehicleDistance += mDistances[solution[i - 1]][solution[0]];
+				vehicleDistance += distances(solution[i - 1], solution[0]);
 				completeDistance += vehicleDistance;
 				std::string frontInfo = "Vehicle " + std::to_string(vehicleCounter + 1) + "(" + std::to_string(vehicleDistance) + "): ";
 				vehicleDistances[vehicleCounter] = vehicleDistance;
 				vehicleStrings[vehicleCounter].insert(0, frontInfo);
 				vehicleStrings[vehicleCounter] += " -> " + mCities[solution[0]].Name;
+				if (HasCapacity())
+				{
+					vehicleStrings[vehicleCounter] += " (Load " + std::to_string(vehicleLoad) + "/" + std::to_string(mCapacity) + ")";
+				}
 				vehicleDistance = 0;
+				vehicleLoad = 0;
 			}
 			vehicleCounter++;
 		}
@@ -911,22 +2235,31 @@ void GeneticAlgorithm::PrintOutput(int* solution) const
 			if (vehicleDistance == 0)
 			{
 				// Increase traveled distance and add starting city
-				vehicleDistance += mDistances[solution[0]][solution[i]];
+				vehicleDistance += distances(solution[0], solution[i]);
 				vehicleStrings[vehicleCounter] = (mCities[solution[0]].Name);
 			}
 			else
 			{
 				// Increase traveled distance
-				vehicleDistance += mDistances[solution[i - 1]][solution[i]];
+				vehicleDistance += distances(solution[i - 1], solution[i]);
 			}
 			vehicleStrings[vehicleCounter] += " -> " + mCities[solution[i]].Name;
+			vehicleLoad += HasCapacity() ? mDemands[solution[i]] : 0;
 		}
 	}
-	int averageDistance = completeDistance / sVehicles;
+	int averageDistance = completeDistance / mVehicles;
 	output += std::to_string(completeDistance) + "|" + std::to_string(averageDistance) + "\n";
+	if (HasCapacity())
+	{
+		output += "Capacity " + std::to_string(mCapacity) + ", load above capacity: " + std::to_string(CapacityExcess(solution)) + "\n";
+	}
+	if (HasTimeWindows())
+	{
+		output += "Time warp (lateness) of all vehicles: " + std::to_string(TimeWarp(solution)) + "\n";
+	}
 
 	// Print Output-String to Console
-	for (int i = 0; i < sVehicles; i++)
+	for (int i = 0; i < mVehicles; i++)
 	{
 		vehicleStrings[i].insert(vehicleStrings[i].find(')'), "|" + std::to_string(std::abs(averageDistance - vehicleDistances[i])));
 	}
@@ -935,4 +2268,13 @@ void GeneticAlgorithm::PrintOutput(int* solution) const
 		output += vehicle + "\n";
 	}
 	std::cout << output << std::endl;
+}
+
+template<int K>
+void GeneticAlgorithm::SelectKernels()
+{
+	static_assert(K == 0 || (K >= sMinSpecializedVehicles && K <= sMaxSpecializedVehicles), "No specialized kernel for this fleet size");
+	mEvaluatePopulationKernel = &GeneticAlgorithm::EvaluatePopulationK<K>;
+	mEvaluateIndividualKernel = &GeneticAlgorithm::EvaluateIndividualK<K>;
+	mMutateKernel = &GeneticAlgorithm::MutateK<K>;
 }
\ No newline at end of file
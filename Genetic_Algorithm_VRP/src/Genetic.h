@@ -1,5 +1,17 @@
+#pragma once
 #include <vector>
+#include <chrono>
 #include <random>
+#include <memory>
+#include <atomic>
+
+#include "DistanceOracle.h"
+#include "LocalSearch.h"
+#include "Migration.h"
+#include "NeighbourIndex.h"
+#include "Population.h"
+#include "Random.h"
+#include "TimeWindow.h"
 
 struct Road
 {
@@ -15,6 +27,7 @@ struct City
 	std::string Name;
 	float X;
 	float Y;
+	int Demand;		// Demand of the customer, 0 if the input has none
 
 	bool Parse(const std::string& cityString);
 };
@@ -24,39 +37,203 @@ class GeneticAlgorithm
 public:
 	// Init needs to be done in cpp to compile on Linux
 	static const int sBlank;
-	static const int sVehicles;
+	static const int sDefaultVehicles;
+
+	// Fleet sizes with their own compile-time specialized kernels, others use the generic version
+	static const int sMinSpecializedVehicles = 2;
+	static const int sMaxSpecializedVehicles = 16;
+
+	// Implementation used for the inversion sequence encoding in crossover
+	enum class InversionMode
+	{
+		Fenwick,	// O(n log n) using a Fenwick tree
+		Legacy,		// Original O(n^2) version
+		Verify		// Runs both and reports differences
+	};
+
+	// Encoding of the chromosome
+	enum class Representation
+	{
+		Separators,	// Cities with sBlank between the routes, the operators move the route boundaries
+		GiantTour	// Order of the cities only, the routes are cut optimally by Split when an individual is evaluated
+	};
 
 	GeneticAlgorithm();
 	GeneticAlgorithm(const GeneticAlgorithm& ga);
 	~GeneticAlgorithm();
 
 	bool ReadFile(std::string path, bool calculateMissingRoutes);
+	void SetSeed(uint64_t seed, int stream);
+	void SetMigration(const std::shared_ptr<MigrationHub>& migration, int island);
+	void SetStopFlag(const std::shared_ptr<std::atomic<bool>>& stop);
+	// Start of a run shared by several islands, the time limit and the time to target count from it even if an island
+	// is started later. Without it BeginRun starts the clock
+	void SetRunStart(std::chrono::steady_clock::time_point start);
+	bool IsStopped() const;
+	void SetVehicles(int vehicles);
+	int GetVehicles() const;
+	// Capacity penalty in units of distance for Split, the fitness weighs the total distance with 0.3
+	int GetSplitPenalty() const;
 	void SolveVRP();
-	int** InitPopulation();
-	int EvaluateFitness(int* populationRoute) const;
-	int** CreateNewGeneration(int** population, int* fitness);
-	int* createInversionSequence(int* individual);
-	int* recreateNumbers(int* inversionSequence, int size);
-	int* Crossover(int* father, int* mother);
-	void sort(int** population, int* fitness, int l, int r);
-	bool CheckSwap(int* router, int first, int second) const;
-	int** Mutate(int** population);
-	int* SaveBest(int** population, int* fitness);
+
+	// SolveVRP in steps, e.g. for a scheduler that time-slices islands: BeginRun creates and evaluates the first
+	// generation, RunGenerations continues for up to count generations and returns false once the run is over.
+	// With synchronous migration RunGenerations also returns early while the island waits for its neighbours' migrants.
+	// EndRun ends the run before that (e.g. a killed island), the neighbours stop waiting for its migrants
+	void BeginRun();
+	bool RunGenerations(int count);
+	void EndRun();
+	void InitPopulation(Population& population);
+	int EvaluateFitness(const int* populationRoute) const;
+	void EvaluatePopulation(Population& population) const;
+	int EvaluateIndividual(const int* individual, int* cache) const;
+	void CreateNewGeneration(Population& population, Population& newPopulation);
+	void sort(Population& population, int l, int r);
+	bool CheckSwap(const int* router, int first, int second) const;
+	void Mutate(Population& population);
+	bool SaveBest(const Population& population, bool force);
 	int* GetBest() const;
+	int GetBestFitness() const;
+	int ScoreRoutes(const int* routeLengths, const int* routeLoads, const int* routeWarps) const;
+
+	// Cache layout: valid flag | route length of every vehicle | position of every blank | load of every vehicle,
+	// with time windows followed by: time warp of every vehicle | schedule valid flag of every vehicle | forward segments |
+	// backward segments
+	int EvaluationCacheSize() const { return 1 + mVehicles + (mVehicles - 1) + mVehicles + (HasTimeWindows() ? ScheduleCacheSize() : 0); }
+	double GetTimeToTarget() const;
+	int GetGenerations() const;
 	void PrintOutput(int* solution) const;
 
-	int**	mDistances;				// All distances between cities
+	std::shared_ptr<const DistanceOracle>	mDistances;	// All distances between cities (matrix or computed on demand), shared between all copies
 	int		mNumCities;				// Number of cities
 	int		mRouteSize;				// Length of Route array
 	int		mPopulationSize;		// Initial population size
-	int		mIterations;			// Number of iterations
+	int		mIterations;			// Maximum number of iterations
+	double	mTimeLimit;				// Maximum run time in milliseconds, 0 if not set
+	int		mMaxStagnation;			// Generations without improvement until the run stops, 0 if not set
 	double	mMutationRate;			// Probability of mutation
+	InversionMode	mInversionMode;	// Encoding/decoding used in crossover
+	Representation	mRepresentation;	// Chromosome encoding
+	double	mLocalSearchRate;		// Probability that an offspring is improved by the local search (set before ReadFile)
+	double	mHeuristicFraction;		// Part of the initial population that is built by the construction heuristics (set before ReadFile)
+	int		mNumNeighbours;			// Neighbours per city in mNeighbourIndex (set before ReadFile), 0 builds no index.
+									// The index is only built if mLocalSearchRate or mHeuristicFraction is set
+	NeighbourIndex::Direction	mNeighbourDirection;	// Ranking of the neighbours for asymmetric distances (set before ReadFile)
+	int		mTargetFitness;			// Fitness that counts as good enough (stops all islands), -1 if not set
+	bool	mUseDistanceCache;		// ReadFile loads/stores cities and distances in a cache file next to the input
+	bool	mVerifyDistanceCache;	// ReadFile hashes the whole cache file before it is used instead of checking the header only
+	bool	mDeltaEvaluation;		// Swap mutations update the cached evaluation instead of evaluating the individual again
+	bool	mBatchEvaluation;		// EvaluatePopulation scores matrix instances with the branch-free FitnessKernels
+	int		mIslandThreads;			// Threads that breed, mutate and evaluate one generation, 1 runs all of it on the island's thread
+	DistanceOracle::Metric	mMetric;	// Matrix, or metric to compute distances from coordinates on demand (set before ReadFile)
+	std::shared_ptr<const NeighbourIndex>	mNeighbourIndex;	// Nearest neighbours of every city, nullptr if mNumNeighbours is 0 or nothing uses it, shared between all copies
 
 	std::vector<City>				mCities;
+	std::vector<int>				mDemands;			// City::Demand of every city for the fitness loops, empty if no city has a demand
+	int								mCapacity;			// Vehicle capacity, 0 if not given (no capacity term in the fitness)
+	int								mCapacityPenalty;	// Fitness penalty per unit of load above the capacity of a vehicle
+	int								mDepot;				// Depot of the instance, -1 if not given (the depot is evolved)
+	std::vector<TimeWindow>			mTimeWindows;		// Time window of every city, empty if the instance has none
+	int								mTimeWarpPenalty;	// Fitness penalty per unit of time warp (lateness) of a vehicle
 	int*							mBestSolution;
+	int								mBestFitness;		// Fitness of mBestSolution
 
 private:
+	// Scratch buffers of one thread that breeds and mutates, allocated once per run
+	struct Workspace
+	{
+		std::vector<int>	Father;
+		std::vector<int>	Mother;
+		std::vector<int>	InversionFather;
+		std::vector<int>	InversionMother;
+		std::vector<int>	InversionChild;
+		std::vector<int>	Positions;
+		std::vector<int>	InversionVerify;
+		std::vector<int>	Fenwick;
+		LocalSearch			Search;		// Set up at the start of every run if mLocalSearchRate is set
+	};
+
+	Population			mPopulation;		// Current generation
+	Population			mNextPopulation;	// Generation that is bred from mPopulation
+	Xoshiro256			mRandom;			// Random stream of this instance, used by all operators
+	std::vector<Workspace>	mWorkspaces;	// One per island thread
+	std::vector<uint64_t>	mSeeds;			// Seeds of the individuals of one parallel step
+
+	std::shared_ptr<MigrationHub>	mMigration;		// Shared by all islands, nullptr if this instance runs alone
+	int								mIsland;		// Index of this island in mMigration
+	int								mPendingExchange;	// Synchronous migration: exchange whose migrants still have to come in, 0 if none
+	double							mTimeToTarget;	// Milliseconds until mTargetFitness was reached, -1 if not reached
+	std::shared_ptr<std::atomic<bool>>	mStop;		// Shared by all islands, set to stop all of them
+	int								mGenerations;	// Generations calculated in the last run
+	int								mStagnation;	// Generations without improvement of mBestFitness
+	std::chrono::steady_clock::time_point	mStart;	// Start of the last run
+	std::chrono::steady_clock::time_point	mRunStart;	// Set by SetRunStart, time_point::min() if not set
+	std::vector<int>				mOrder;			// Scratch buffer to rank individuals for migration
+	std::vector<std::unique_ptr<MigrationHub::Packet>>	mInbox;
+
 	void PrintDistances() const;
 	void PrintCities() const;
-	bool ValidateRoute(int* route, bool assertOnError) const;
+	bool ValidateRoute(const int* route, bool assertOnError) const;
+	bool UpdateNeighbourIndex(const std::shared_ptr<const NeighbourIndex>& cached);
+	int SeedPopulation(Population& population);
+
+	// Calls body(i, workspace, random) for every i < count, in parallel chunks with mIslandThreads > 1.
+	// Every i has its own random stream seeded from mRandom, so the result does not depend on the number of threads
+	template<typename Body> void ForEachIndividual(int count, Body body);
+	void Breed(Population& population, Population& newPopulation, int i, Workspace& workspace, Xoshiro256& random);
+
+	int ScheduleCacheSize() const { return 2 * mVehicles + 2 * TimeSegment::sInts * mRouteSize; }
+	bool HasCapacity() const { return mCapacity > 0 && !mDemands.empty(); }
+	bool HasTimeWindows() const { return !mTimeWindows.empty(); }
+	int CapacityExcess(const int* route) const;
+	int TimeWarp(const int* route) const;
+	int RouteTimeWarp(const int* individual, int first, int last) const;
+
+	// Forward (depot to position) and backward (position to depot) time segments of the route between first and last,
+	// returns the time warp of the route
+	int BuildSchedule(const int* individual, int first, int last, int* forward, int* backward) const;
+	TimeSegment Prefix(const int* individual, const int* forward, int i) const;
+	TimeSegment Suffix(const int* individual, const int* backward, int i) const;
+
+	// Kernels for K vehicles, K = 0 is the generic version for any mVehicles.
+	// SetVehicles selects the instantiation once, so the hot loops see a constant fleet size
+	template<int K> void SelectKernels();
+	template<int K> void EvaluatePopulationK(Population& population) const;
+	template<int K> int EvaluateIndividualK(const int* individual, int* cache) const;
+	template<int K> int EvaluateBatchK(const int* individual, int* cache, const int* matrix, int stride) const;
+	template<int K> int RouteFitnessK(const int* routeLengths) const;
+	template<int K> int CapacityPenaltyK(const int* routeLoads) const;
+	template<int K> int RouteIndexK(const int* blanks, int i) const;
+	template<int K> int UpdateTimeWarpsK(const int* individual, int* cache) const;
+	template<int K> void SwapTimeWarpK(const int* individual, int* cache, int first, int second) const;
+	template<int K> void AccumulateStep(const int* individual, const int* blanks, int i, int sign, int* routeLengths) const;
+	template<int K> int SwapWithDelta(int* individual, int* cache, int first, int second) const;
+	template<int K> void MutateK(Population& population);
+	template<int K> void MutateIndividualK(Population& population, int i, Xoshiro256& random);
+
+	int		mVehicles;		// Number of vehicles (routes) of a solution
+	void	(GeneticAlgorithm::*mEvaluatePopulationKernel)(Population& population) const;
+	int		(GeneticAlgorithm::*mEvaluateIndividualKernel)(const int* individual, int* cache) const;
+	void	(GeneticAlgorithm::*mMutateKernel)(Population& population);
+
+	// Giant tour representation: rows hold the cities in visiting order followed by all blanks until they are evaluated,
+	// Split then writes the optimal routes back in the separator form, so everything else sees the same layout
+	void SplitIndividual(int* individual) const;
+	void CompactIndividual(int* individual) const;
+	void InitGiantTours(Population& population, int begin);
+	void OrderCrossover(int* father, int* mother, int* child, Workspace& workspace, Xoshiro256& random);
+	void MutateGiantTours(Population& population);
+
+	bool AdvanceRun(int count);
+	void Emigrate(const Population& population);
+	bool Immigrate(Population& population);
+
+	void Crossover(int* father, int* mother, int* child, Workspace& workspace, Xoshiro256& random);
+	void createInversionSequence(const int* individual, int* inversionSequence, Workspace& workspace);
+	void recreateNumbers(const int* inversionSequence, int size, int* numbers, Workspace& workspace);
+	void createInversionSequenceLegacy(const int* individual, int* inversionSequence) const;
+	void createInversionSequenceFenwick(const int* individual, int* inversionSequence, Workspace& workspace);
+	void recreateNumbersLegacy(const int* inversionSequence, int size, int* numbers, Workspace& workspace);
+	void recreateNumbersFenwick(const int* inversionSequence, int size, int* numbers, Workspace& workspace);
+	void VerifyInversion(const int* expected, const int* actual, int size, const std::string& function) const;
 };
\ No newline at end of file
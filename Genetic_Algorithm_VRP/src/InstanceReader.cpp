@@ -0,0 +1,240 @@
+#include <iostream>
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <omp.h>
+
+#include "InstanceReader.h"
+#include "FactParser.h"
+#include "SolomonReader.h"
+#include "TsplibReader.h"
+
+namespace
+{
+	bool IsWhitespace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+}
+
+bool TokenStream::AtEnd()
+{
+	while (mCurrent < mEnd && IsWhitespace(*mCurrent))
+	{
+		mCurrent++;
+	}
+	return mCurrent == mEnd;
+}
+
+std::string_view TokenStream::Next()
+{
+	AtEnd();
+	const char* begin = mCurrent;
+	while (mCurrent < mEnd && !IsWhitespace(*mCurrent))
+	{
+		mCurrent++;
+	}
+	return std::string_view(begin, static_cast<size_t>(mCurrent - begin));
+}
+
+std::string_view TokenStream::Keyword()
+{
+	AtEnd();
+	const char* begin = mCurrent;
+	while (mCurrent < mEnd && !IsWhitespace(*mCurrent) && *mCurrent != ':')
+	{
+		mCurrent++;
+	}
+	std::string_view keyword(begin, static_cast<size_t>(mCurrent - begin));
+
+	const char* next = mCurrent;
+	while (next < mEnd && (*next == ' ' || *next == '\t'))
+	{
+		next++;
+	}
+	if (next < mEnd && *next == ':')
+	{
+		mCurrent = next + 1;
+	}
+	return keyword;
+}
+
+std::string_view TokenStream::RestOfLine()
+{
+	while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t'))
+	{
+		mCurrent++;
+	}
+	const char* begin = mCurrent;
+	while (mCurrent < mEnd && *mCurrent != '\n')
+	{
+		mCurrent++;
+	}
+	const char* last = mCurrent;
+	while (last > begin && IsWhitespace(last[-1]))
+	{
+		last--;
+	}
+	return std::string_view(begin, static_cast<size_t>(last - begin));
+}
+
+template<typename T>
+bool TokenStream::Number(T& value)
+{
+	std::string_view token = Next();
+	const char* end = token.data() + token.size();
+	std::from_chars_result result = std::from_chars(token.data(), end, value);
+	return !token.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+template bool TokenStream::Number<int>(int&);
+template bool TokenStream::Number<double>(double&);
+
+int TokenStream::TokensInLine() const
+{
+	int count = 0;
+	bool inToken = false;
+	for (const char* current = mCurrent; current < mEnd && *current != '\n'; current++)
+	{
+		bool whitespace = IsWhitespace(*current);
+		if (!whitespace && !inToken)
+		{
+			count++;
+		}
+		inToken = !whitespace;
+	}
+	return count;
+}
+
+const InstanceReader* InstanceReader::Detect(const char* data, size_t size)
+{
+	static const TsplibReader sTsplib;
+	static const SolomonReader sSolomon;
+	static const FactReader sFacts;
+	static const MatrixReader sMatrix;
+	static const InstanceReader* sReaders[] = { &sTsplib, &sSolomon, &sFacts, &sMatrix };
+
+	std::string_view head(data, std::min<size_t>(size, 4096U));
+	for (const InstanceReader* reader : sReaders)
+	{
+		if (reader->CanRead(head))
+		{
+			return reader;
+		}
+	}
+	return nullptr;
+}
+
+bool FactReader::CanRead(std::string_view head) const
+{
+	return head.find("road(") != std::string_view::npos || head.find("city(") != std::string_view::npos;
+}
+
+bool FactReader::Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const
+{
+	// Parse facts in place, large files are split into chunks parsed in parallel
+	FactParser parser;
+	if (!parser.Parse(data, size, omp_get_max_threads()))
+	{
+		return false;
+	}
+
+	instance.Cities.clear();
+	instance.Cities.reserve(parser.Cities().size());
+	instance.X.clear();
+	instance.Y.clear();
+	for (const auto& city : parser.Cities())
+	{
+		instance.Cities.push_back(City{ std::string(city.Name), city.X, city.Y, city.Demand });
+		instance.X.push_back(city.X);
+		instance.Y.push_back(city.Y);
+	}
+	instance.Metric = DistanceOracle::Metric::GreatCircle;
+	instance.Distances = nullptr;
+	if (!buildMatrix)
+	{
+		return true;
+	}
+
+	// Created adj. matrix, -1 where there is no direct road
+	int numCities = static_cast<int>(instance.Cities.size());
+	std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(numCities);
+	DistanceMatrix& distances = *distancePtr;
+	for (int i = 0; i < numCities; i++)
+	{
+		for (int j = 0; j < numCities; j++)
+		{
+			distances[i][j] = i == j ? 0 : -1;
+		}
+	}
+
+	// Store values in adj. matrix
+	for (const auto& road : parser.Roads())
+	{
+		distances[road.City1][road.City2] = road.Distance;
+		distances[road.City2][road.City1] = road.Distance;
+	}
+
+	instance.HasMissingRoutes = true;
+	instance.Distances = distancePtr;
+	return true;
+}
+
+bool MatrixReader::CanRead(std::string_view head) const
+{
+	bool hasDigit = false;
+	for (char c : head)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			hasDigit = true;
+		}
+		else if (!IsWhitespace(c) && c != '-' && c != '.')
+		{
+			return false;
+		}
+	}
+	return hasDigit;
+}
+
+bool MatrixReader::Read(const char* data, size_t size, bool, Instance& instance) const
+{
+	// The first row defines the number of cities
+	TokenStream tokens(data, data + size);
+	tokens.AtEnd();
+	int numCities = tokens.TokensInLine();
+
+	std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(numCities);
+	DistanceMatrix& distances = *distancePtr;
+	for (int i = 0; i < numCities; i++)
+	{
+		for (int j = 0; j < numCities; j++)
+		{
+			double distance;
+			if (!tokens.Number(distance))
+			{
+				std::cout << "Distance matrix: expected " << numCities << "x" << numCities << " numbers, row " << i + 1 << " is incomplete" << std::endl;
+				return false;
+			}
+			distances[i][j] = static_cast<int>(std::lround(distance));
+		}
+	}
+	if (!tokens.AtEnd())
+	{
+		std::cout << "Distance matrix: more than " << numCities << "x" << numCities << " numbers" << std::endl;
+		return false;
+	}
+
+	// No coordinates, cities are named by their row (1-based like TSPLIB)
+	instance.Cities.clear();
+	for (int i = 0; i < numCities; i++)
+	{
+		instance.Cities.push_back(City{ std::to_string(i + 1), 0.0f, 0.0f, 0 });
+	}
+	instance.X.clear();
+	instance.Y.clear();
+	instance.Metric = DistanceOracle::Metric::Matrix;
+	instance.HasMissingRoutes = false;
+	instance.Distances = distancePtr;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "DistanceMatrix.h"
+#include "DistanceOracle.h"
+#include "Genetic.h"
+#include "NeighbourIndex.h"
+#include "TimeWindow.h"
+
+// Problem data of one input file
+struct Instance
+{
+	std::vector<City>	Cities;				// City::Demand is 0 if the format has no demands
+	int					Capacity = 0;		// Vehicle capacity, 0 if not given
+	int					Depot = -1;			// Index of the depot, -1 if not given
+	std::vector<TimeWindow>	TimeWindows;	// Time window of every city, empty if the format has none
+	bool				HasMissingRoutes = false;	// Distances contains -1 for cities without a direct road
+	std::shared_ptr<const DistanceMatrix>	Distances;	// nullptr if the reader was asked not to build it
+	std::shared_ptr<const NeighbourIndex>	Neighbours;	// Only set by ReadFile and the cache, nullptr if not built
+
+	// Exact coordinates and the metric they define, Metric::Matrix if the input has no coordinates
+	std::vector<double>		X;
+	std::vector<double>		Y;
+	DistanceOracle::Metric	Metric = DistanceOracle::Metric::Matrix;
+};
+
+// Forward-only tokenizer over a buffer, tokens are separated by whitespace
+class TokenStream
+{
+public:
+	TokenStream(const char* begin, const char* end) : mCurrent(begin), mEnd(end) {}
+
+	bool AtEnd();
+
+	// Next token, empty at the end of the buffer
+	std::string_view Next();
+
+	// Next token up to whitespace or ':', a following ':' on the same line is skipped
+	std::string_view Keyword();
+
+	// Remainder of the current line without surrounding whitespace
+	std::string_view RestOfLine();
+
+	// Parses the next token completely as number
+	template<typename T>
+	bool Number(T& value);
+
+	// Number of tokens until the end of the current line
+	int TokensInLine() const;
+
+private:
+	const char*	mCurrent;
+	const char*	mEnd;
+};
+
+// Reads one input format from a buffer (usually a mapped file) in a single forward pass.
+// GeneticAlgorithm::ReadFile picks the first reader that accepts the start of the file.
+class InstanceReader
+{
+public:
+	virtual ~InstanceReader() = default;
+
+	virtual const char* Name() const = 0;
+
+	// Cheap check on the first few KB of the file
+	virtual bool CanRead(std::string_view head) const = 0;
+
+	// Without buildMatrix, readers of inputs with coordinates leave Distances empty (O(N) memory)
+	virtual bool Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const = 0;
+
+	// Reader for the format of data, nullptr if no reader accepts it
+	static const InstanceReader* Detect(const char* data, size_t size);
+};
+
+// road(city1, city2, distance). and city(name, x, y). facts (Data/US.txt, Data/Romania.txt),
+// the coordinates are latitude and longitude, so their metric is the great circle distance
+class FactReader : public InstanceReader
+{
+public:
+	const char* Name() const override { return "Prolog facts"; }
+	bool CanRead(std::string_view head) const override;
+	bool Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const override;
+};
+
+// Plain square matrix of whitespace separated distances, one row per line (Data/dantzig42_d.txt).
+// There are no coordinates, the matrix is always built
+class MatrixReader : public InstanceReader
+{
+public:
+	const char* Name() const override { return "distance matrix"; }
+	bool CanRead(std::string_view head) const override;
+	bool Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const override;
+};
\ No newline at end of file
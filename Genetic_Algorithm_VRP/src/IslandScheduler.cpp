@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <omp.h>
+
+#include "Genetic.h"
+#include "IslandScheduler.h"
+
+IslandScheduler::IslandScheduler(int numWorkers, int sliceGenerations)
+	: mSliceGenerations(std::max(sliceGenerations, 1))
+	, mQueued(0)
+	, mRunnable(0)
+	, mNextQueue(0)
+	, mShutdown(false)
+	, mSlices(0)
+	, mSteals(0)
+{
+	numWorkers = std::max(numWorkers, 1);
+	for (int i = 0; i < numWorkers; i++)
+	{
+		mQueues.push_back(std::make_unique<Queue>());
+	}
+	for (int i = 0; i < numWorkers; i++)
+	{
+		mWorkers.emplace_back(&IslandScheduler::Work, this, i);
+	}
+}
+
+IslandScheduler::~IslandScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mWork.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+int IslandScheduler::Spawn(GeneticAlgorithm* island)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	const int id = static_cast<int>(mIslands.size());
+	mIslands.push_back(std::make_unique<Island>(Island{ island, State::Queued, false, false, false }));
+	mRunnable++;
+	Push(mNextQueue++ % NumWorkers(), id);
+	return id;
+}
+
+void IslandScheduler::Pause(int id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Island& island = *mIslands[id];
+	if (island.Status == State::Queued || island.Status == State::Running)
+	{
+		island.PauseRequested = true;
+	}
+}
+
+void IslandScheduler::Resume(int id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Island& island = *mIslands[id];
+	island.PauseRequested = false;
+	if (island.Status == State::Paused)
+	{
+		island.Status = State::Queued;
+		mRunnable++;
+		Push(mNextQueue++ % NumWorkers(), id);
+	}
+}
+
+void IslandScheduler::Kill(int id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Island& island = *mIslands[id];
+	if (island.Status == State::Paused)
+	{
+		island.Status = State::Done;
+		island.Algorithm->EndRun();
+	}
+	else if (island.Status != State::Done)
+	{
+		island.KillRequested = true;
+	}
+}
+
+void IslandScheduler::Wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [this] { return mRunnable == 0; });
+}
+
+// Called with mMutex held
+void IslandScheduler::Push(int queue, int id)
+{
+	{
+		std::lock_guard<std::mutex> lock(mQueues[queue]->Mutex);
+		mQueues[queue]->Islands.push_back(id);
+	}
+	mQueued++;
+	mWork.notify_one();
+}
+
+bool IslandScheduler::Take(int worker, int& id)
+{
+	bool found = false;
+	{
+		Queue& own = *mQueues[worker];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Islands.empty())
+		{
+			id = own.Islands.front();
+			own.Islands.pop_front();
+			found = true;
+		}
+	}
+	for (int k = 1; k < NumWorkers() && !found; k++)
+	{
+		Queue& other = *mQueues[(worker + k) % NumWorkers()];
+		std::lock_guard<std::mutex> lock(other.Mutex);
+		if (!other.Islands.empty())
+		{
+			id = other.Islands.back();
+			other.Islands.pop_back();
+			found = true;
+			mSteals++;
+		}
+	}
+	if (found)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueued--;
+	}
+	return found;
+}
+
+void IslandScheduler::Work(int worker)
+{
+	// Parallel regions of an island without island threads stay on its worker
+	omp_set_num_threads(1);
+
+	for (;;)
+	{
+		int id = -1;
+		if (!Take(worker, id))
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWork.wait(lock, [this] { return mShutdown || mQueued > 0; });
+			if (mShutdown)
+			{
+				return;
+			}
+			continue;
+		}
+
+		GeneticAlgorithm* algorithm = nullptr;
+		bool start = false;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			Island& island = *mIslands[id];
+			// An island that was not started before the run was stopped is not even initialized
+			const bool stopped = !island.Started && island.Algorithm->IsStopped();
+			if (island.KillRequested || stopped || island.PauseRequested)
+			{
+				island.Status = island.KillRequested || stopped ? State::Done : State::Paused;
+				if (island.Status == State::Done)
+				{
+					island.Algorithm->EndRun();
+				}
+				if (--mRunnable == 0)
+				{
+					mIdle.notify_all();
+				}
+				continue;
+			}
+			island.Status = State::Running;
+			algorithm = island.Algorithm;
+			start = !island.Started;
+			island.Started = true;
+		}
+
+		if (start)
+		{
+			algorithm->BeginRun();
+		}
+		const bool running = algorithm->RunGenerations(mSliceGenerations);
+		mSlices++;
+
+		// Yield: the island goes to the back of the queue of this worker unless it is over or paused
+		std::lock_guard<std::mutex> lock(mMutex);
+		Island& island = *mIslands[id];
+		if (running && !island.KillRequested && !island.PauseRequested)
+		{
+			island.Status = State::Queued;
+			Push(worker, id);
+			continue;
+		}
+		island.Status = running && !island.KillRequested ? State::Paused : State::Done;
+		if (island.Status == State::Done)
+		{
+			// A killed island leaves the migration, its neighbours must not wait for it
+			algorithm->EndRun();
+		}
+		if (--mRunnable == 0)
+		{
+			mIdle.notify_all();
+		}
+	}
+}
\ No newline at end of file
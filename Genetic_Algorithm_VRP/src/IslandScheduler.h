@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class GeneticAlgorithm;
+
+// Runs islands as tasks on a persistent set of worker threads, so there can be more islands than cores.
+// A task runs a slice of generations of one island and then yields: the island goes back to the queue of its worker.
+// Every worker takes islands from the front of its own queue (round robin between its islands) and steals from the
+// back of another queue when its own is empty, so islands that finish early or run faster are balanced out.
+// Islands can be spawned, paused, resumed and killed while the others run, a pause or kill takes effect at the end
+// of the current slice. The scheduler does not own the islands
+class IslandScheduler
+{
+public:
+	IslandScheduler(int numWorkers, int sliceGenerations);
+	~IslandScheduler();
+
+	IslandScheduler(const IslandScheduler&) = delete;
+	IslandScheduler& operator=(const IslandScheduler&) = delete;
+
+	// Queues an island, the worker that takes it first calls BeginRun unless the island is stopped already.
+	// Returns the id of the island
+	int Spawn(GeneticAlgorithm* island);
+
+	// With synchronous migration, the neighbours of a paused island wait for it at their next exchange
+	void Pause(int id);
+	void Resume(int id);
+
+	// Stops the island for good, it keeps the best solution found so far
+	void Kill(int id);
+
+	// Blocks until no island is queued or running, paused islands stay paused
+	void Wait();
+
+	int NumWorkers() const { return static_cast<int>(mWorkers.size()); }
+	long long Slices() const { return mSlices.load(); }
+	long long Steals() const { return mSteals.load(); }
+
+private:
+	enum class State
+	{
+		Queued,
+		Running,
+		Paused,
+		Done		// Finished its run or killed
+	};
+
+	struct Island
+	{
+		GeneticAlgorithm*	Algorithm;
+		State				Status;
+		bool				Started;			// BeginRun was called
+		bool				PauseRequested;
+		bool				KillRequested;
+	};
+
+	struct Queue
+	{
+		std::mutex			Mutex;
+		std::deque<int>		Islands;
+	};
+
+	int				mSliceGenerations;	// Generations per task
+	std::mutex		mMutex;				// Guards mIslands, mQueued, mRunnable and mShutdown
+	std::condition_variable	mWork;		// Signalled when an island is queued or on shutdown
+	std::condition_variable	mIdle;		// Signalled when mRunnable drops to 0
+	std::vector<std::unique_ptr<Island>>	mIslands;
+	int				mQueued;			// Islands in the queues
+	int				mRunnable;			// Queued or running islands
+	int				mNextQueue;			// Queue of the next spawned or resumed island
+	bool			mShutdown;
+	std::atomic<long long>	mSlices;
+	std::atomic<long long>	mSteals;
+	std::vector<std::unique_ptr<Queue>>	mQueues;	// One per worker
+	std::vector<std::thread>	mWorkers;
+
+	void Push(int queue, int id);
+	bool Take(int worker, int& id);
+	void Work(int worker);
+};
\ No newline at end of file
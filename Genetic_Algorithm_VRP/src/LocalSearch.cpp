@@ -0,0 +1,486 @@
+#include <algorithm>
+
+#include "Genetic.h"
+#include "LocalSearch.h"
+#include "Profiler.h"
+
+LocalSearch::LocalSearch()
+	: mGa(nullptr)
+	, mDistances(nullptr)
+	, mDemands(nullptr)
+	, mTimeWindows(nullptr)
+	, mNeighbours(nullptr)
+	, mDepot(0)
+	, mFitness(0)
+{
+}
+
+void LocalSearch::Setup(const GeneticAlgorithm& ga)
+{
+	const int numCities = ga.mNumCities;
+	mGa = &ga;
+	mDistances = ga.mDistances.get();
+	mDemands = ga.mDemands.empty() ? nullptr : ga.mDemands.data();
+	mTimeWindows = ga.mTimeWindows.empty() ? nullptr : ga.mTimeWindows.data();
+	mNeighbours = ga.mNeighbourIndex.get();
+
+	mRouteOf.resize(numCities);
+	mPositionOf.resize(numCities);
+	mDontLook.resize(numCities);
+}
+
+bool LocalSearch::Improve(int* individual, Xoshiro256& random)
+{
+	PROFILE_SCOPE("LocalSearch");
+	const int routeSize = mGa->mRouteSize;
+	const int vehicles = mGa->GetVehicles();
+	mDepot = individual[0];
+	if (mDepot == GeneticAlgorithm::sBlank)
+	{
+		return false;
+	}
+
+	// Routes out of the chromosome, every route needs at least one customer
+	mRoutes.resize(vehicles);
+	for (Route& route : mRoutes)
+	{
+		route.Nodes.assign(1, mDepot);
+	}
+	int route = 0;
+	for (int i = 1; i < routeSize; i++)
+	{
+		if (individual[i] != GeneticAlgorithm::sBlank)
+		{
+			mRoutes[route].Nodes.push_back(individual[i]);
+		}
+		else if (++route == vehicles)
+		{
+			return false;
+		}
+	}
+	mLengths.resize(vehicles);
+	mLoads.resize(vehicles);
+	mWarps.resize(vehicles);
+	for (int r = 0; r < vehicles; r++)
+	{
+		mRoutes[r].Nodes.push_back(mDepot);
+		if (mRoutes[r].Size() == 0)
+		{
+			return false;
+		}
+		Rebuild(r);
+	}
+	mFitness = mGa->ScoreRoutes(mLengths.data(), mLoads.data(), mWarps.data());
+
+	// Customers are visited in random order until none of them has an improving move
+	mOrder.clear();
+	for (int city = 0; city < mGa->mNumCities; city++)
+	{
+		if (city != mDepot)
+		{
+			mOrder.push_back(city);
+		}
+	}
+	std::shuffle(mOrder.begin(), mOrder.end(), random);
+	std::fill(mDontLook.begin(), mDontLook.end(), 0);
+
+	bool improved = true;
+	while (improved)
+	{
+		improved = false;
+		for (int u : mOrder)
+		{
+			if (mDontLook[u] != 0)
+			{
+				continue;
+			}
+			if (ImproveCustomer(u))
+			{
+				improved = true;
+			}
+			else
+			{
+				mDontLook[u] = 1;
+			}
+		}
+	}
+
+	// Write the routes back in the separator form
+	int position = 1;
+	for (int r = 0; r < vehicles; r++)
+	{
+		if (r > 0)
+		{
+			individual[position++] = GeneticAlgorithm::sBlank;
+		}
+		const std::vector<int>& nodes = mRoutes[r].Nodes;
+		std::copy(nodes.begin() + 1, nodes.end() - 1, individual + position);
+		position += mRoutes[r].Size();
+	}
+	return true;
+}
+
+// Prefix sums, segments and positions of a changed route
+void LocalSearch::Rebuild(int r)
+{
+	const DistanceOracle& distances = *mDistances;
+	Route& route = mRoutes[r];
+	const std::vector<int>& nodes = route.Nodes;
+	const int size = route.Size();
+
+	route.Forward.resize(size + 2);
+	route.Backward.resize(size + 2);
+	route.Load.resize(size + 2);
+	route.Forward[0] = 0;
+	route.Backward[0] = 0;
+	route.Load[0] = 0;
+	for (int p = 1; p <= size + 1; p++)
+	{
+		route.Forward[p] = route.Forward[p - 1] + distances(nodes[p - 1], nodes[p]);
+		route.Backward[p] = route.Backward[p - 1] + distances(nodes[p], nodes[p - 1]);
+		route.Load[p] = route.Load[p - 1] + (mDemands != nullptr && p <= size ? mDemands[nodes[p]] : 0);
+	}
+	for (int p = 1; p <= size; p++)
+	{
+		mRouteOf[nodes[p]] = r;
+		mPositionOf[nodes[p]] = p;
+	}
+
+	mLengths[r] = route.Forward[size + 1];
+	mLoads[r] = route.Load[size + 1];
+	mWarps[r] = 0;
+	if (mTimeWindows != nullptr)
+	{
+		route.Prefix.resize(size + 2);
+		route.Suffix.resize(size + 2);
+		route.Prefix[0] = TimeSegment::Visit(mTimeWindows[nodes[0]]);
+		for (int p = 1; p <= size + 1; p++)
+		{
+			route.Prefix[p] = route.Prefix[p - 1].Then(TimeSegment::Visit(mTimeWindows[nodes[p]]), distances(nodes[p - 1], nodes[p]));
+		}
+		route.Suffix[size + 1] = TimeSegment::Visit(mTimeWindows[nodes[size + 1]]);
+		for (int p = size; p >= 0; p--)
+		{
+			route.Suffix[p] = TimeSegment::Visit(mTimeWindows[nodes[p]]).Then(route.Suffix[p + 1], distances(nodes[p], nodes[p + 1]));
+		}
+		mWarps[r] = route.Prefix[size + 1].TimeWarp;
+	}
+}
+
+// Fitness with the length, load and time warp of one or two routes (second = -1) replaced
+int LocalSearch::Score(int first, int firstLength, int firstLoad, int firstWarp, int second, int secondLength, int secondLoad, int secondWarp)
+{
+	int lengths[] = { mLengths[first], second >= 0 ? mLengths[second] : 0 };
+	int loads[] = { mLoads[first], second >= 0 ? mLoads[second] : 0 };
+	int warps[] = { mWarps[first], second >= 0 ? mWarps[second] : 0 };
+
+	mLengths[first] = firstLength;
+	mLoads[first] = firstLoad;
+	mWarps[first] = firstWarp;
+	if (second >= 0)
+	{
+		mLengths[second] = secondLength;
+		mLoads[second] = secondLoad;
+		mWarps[second] = secondWarp;
+	}
+	int fitness = mGa->ScoreRoutes(mLengths.data(), mLoads.data(), mWarps.data());
+
+	mLengths[first] = lengths[0];
+	mLoads[first] = loads[0];
+	mWarps[first] = warps[0];
+	if (second >= 0)
+	{
+		mLengths[second] = lengths[1];
+		mLoads[second] = loads[1];
+		mWarps[second] = warps[1];
+	}
+	return fitness;
+}
+
+// Time segment of the positions from to to of a route, backwards if to is before from
+TimeSegment LocalSearch::Path(const Route& route, int from, int to) const
+{
+	const DistanceOracle& distances = *mDistances;
+	const int step = from <= to ? 1 : -1;
+	TimeSegment segment = TimeSegment::Visit(mTimeWindows[route.Nodes[from]]);
+	for (int p = from + step; p != to + step; p += step)
+	{
+		segment = segment.Then(TimeSegment::Visit(mTimeWindows[route.Nodes[p]]), distances(route.Nodes[p - step], route.Nodes[p]));
+	}
+	return segment;
+}
+
+// Segment ending at city last followed by next starting at city first
+TimeSegment LocalSearch::Join(const TimeSegment& segment, int last, const TimeSegment& next, int first) const
+{
+	return segment.Then(next, (*mDistances)(last, first));
+}
+
+void LocalSearch::Activate(int city)
+{
+	mDontLook[city] = 0;
+}
+
+// First improving move between u and one of its neighbours, the move is applied
+bool LocalSearch::ImproveCustomer(int u)
+{
+	for (const uint32_t* neighbour = mNeighbours->Begin(u); neighbour != mNeighbours->End(u); neighbour++)
+	{
+		int v = static_cast<int>(*neighbour);
+		if (v == mDepot)
+		{
+			continue;
+		}
+
+		// Chains of one to three customers starting at u go behind or in front of v
+		int uRoute = mRouteOf[u];
+		int uPosition = mPositionOf[u];
+		int vRoute = mRouteOf[v];
+		int vPosition = mPositionOf[v];
+		for (int length = 1; length <= 3 && uPosition + length - 1 <= mRoutes[uRoute].Size(); length++)
+		{
+			if (Relocate(uRoute, uPosition, uPosition + length - 1, vRoute, vPosition)
+				|| Relocate(uRoute, uPosition, uPosition + length - 1, vRoute, vPosition - 1))
+			{
+				return true;
+			}
+		}
+		if (Exchange(u, v))
+		{
+			return true;
+		}
+		if (uRoute == vRoute && TwoOpt(u, v))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Moves the customers between first and last (positions in fromRoute) behind position after of toRoute
+bool LocalSearch::Relocate(int fromRoute, int first, int last, int toRoute, int after)
+{
+	const DistanceOracle& distances = *mDistances;
+	Route& from = mRoutes[fromRoute];
+	Route& to = mRoutes[toRoute];
+	const std::vector<int>& n = from.Nodes;
+	const std::vector<int>& m = to.Nodes;
+	const int chainDistance = from.Forward[last] - from.Forward[first];
+	int fitness;
+
+	if (fromRoute != toRoute)
+	{
+		if (last - first + 1 >= from.Size())
+		{
+			// Would leave an empty route
+			return false;
+		}
+		int chainLoad = from.Load[last] - from.Load[first - 1];
+		int fromLength = mLengths[fromRoute] - distances(n[first - 1], n[first]) - chainDistance - distances(n[last], n[last + 1]) + distances(n[first - 1], n[last + 1]);
+		int toLength = mLengths[toRoute] - distances(m[after], m[after + 1]) + distances(m[after], n[first]) + chainDistance + distances(n[last], m[after + 1]);
+		int fromWarp = 0;
+		int toWarp = 0;
+		if (mTimeWindows != nullptr)
+		{
+			fromWarp = Join(from.Prefix[first - 1], n[first - 1], from.Suffix[last + 1], n[last + 1]).TimeWarp;
+			TimeSegment chain = Path(from, first, last);
+			toWarp = Join(Join(to.Prefix[after], m[after], chain, n[first]), n[last], to.Suffix[after + 1], m[after + 1]).TimeWarp;
+		}
+		fitness = Score(fromRoute, fromLength, mLoads[fromRoute] - chainLoad, fromWarp, toRoute, toLength, mLoads[toRoute] + chainLoad, toWarp);
+		if (fitness >= mFitness)
+		{
+			return false;
+		}
+
+		int touched[] = { n[first - 1], n[last + 1], m[after], m[after + 1] };
+		to.Nodes.insert(to.Nodes.begin() + after + 1, from.Nodes.begin() + first, from.Nodes.begin() + last + 1);
+		from.Nodes.erase(from.Nodes.begin() + first, from.Nodes.begin() + last + 1);
+		Rebuild(fromRoute);
+		Rebuild(toRoute);
+		for (int city : touched)
+		{
+			Activate(city);
+		}
+	}
+	else
+	{
+		if (after >= first - 1 && after <= last)
+		{
+			// Chain would stay where it is
+			return false;
+		}
+		int length = mLengths[fromRoute] - distances(n[first - 1], n[first]) - distances(n[last], n[last + 1]) + distances(n[first - 1], n[last + 1])
+			- distances(n[after], n[after + 1]) + distances(n[after], n[first]) + distances(n[last], n[after + 1]);
+		int warp = 0;
+		if (mTimeWindows != nullptr)
+		{
+			TimeSegment chain = Path(from, first, last);
+			TimeSegment segment;
+			if (after < first)
+			{
+				segment = Join(Join(from.Prefix[after], n[after], chain, n[first]), n[last], Path(from, after + 1, first - 1), n[after + 1]);
+				segment = Join(segment, n[first - 1], from.Suffix[last + 1], n[last + 1]);
+			}
+			else
+			{
+				segment = Join(from.Prefix[first - 1], n[first - 1], Path(from, last + 1, after), n[last + 1]);
+				segment = Join(Join(segment, n[after], chain, n[first]), n[last], from.Suffix[after + 1], n[after + 1]);
+			}
+			warp = segment.TimeWarp;
+		}
+		fitness = Score(fromRoute, length, mLoads[fromRoute], warp, -1, 0, 0, 0);
+		if (fitness >= mFitness)
+		{
+			return false;
+		}
+
+		int touched[] = { n[first - 1], n[last + 1], n[after], n[after + 1] };
+		auto nodes = from.Nodes.begin();
+		if (after < first)
+		{
+			std::rotate(nodes + after + 1, nodes + first, nodes + last + 1);
+		}
+		else
+		{
+			std::rotate(nodes + first, nodes + last + 1, nodes + after + 1);
+		}
+		Rebuild(fromRoute);
+		for (int city : touched)
+		{
+			Activate(city);
+		}
+	}
+	mFitness = fitness;
+	return true;
+}
+
+// Exchanges the customers u and v
+bool LocalSearch::Exchange(int u, int v)
+{
+	const DistanceOracle& distances = *mDistances;
+	int uRoute = mRouteOf[u];
+	int vRoute = mRouteOf[v];
+	int fitness;
+
+	if (uRoute != vRoute)
+	{
+		Route& a = mRoutes[uRoute];
+		Route& b = mRoutes[vRoute];
+		int p = mPositionOf[u];
+		int q = mPositionOf[v];
+		const std::vector<int>& n = a.Nodes;
+		const std::vector<int>& m = b.Nodes;
+		int uLength = mLengths[uRoute] - distances(n[p - 1], u) - distances(u, n[p + 1]) + distances(n[p - 1], v) + distances(v, n[p + 1]);
+		int vLength = mLengths[vRoute] - distances(m[q - 1], v) - distances(v, m[q + 1]) + distances(m[q - 1], u) + distances(u, m[q + 1]);
+		int difference = mDemands != nullptr ? mDemands[v] - mDemands[u] : 0;
+		int uWarp = 0;
+		int vWarp = 0;
+		if (mTimeWindows != nullptr)
+		{
+			uWarp = Join(Join(a.Prefix[p - 1], n[p - 1], TimeSegment::Visit(mTimeWindows[v]), v), v, a.Suffix[p + 1], n[p + 1]).TimeWarp;
+			vWarp = Join(Join(b.Prefix[q - 1], m[q - 1], TimeSegment::Visit(mTimeWindows[u]), u), u, b.Suffix[q + 1], m[q + 1]).TimeWarp;
+		}
+		fitness = Score(uRoute, uLength, mLoads[uRoute] + difference, uWarp, vRoute, vLength, mLoads[vRoute] - difference, vWarp);
+		if (fitness >= mFitness)
+		{
+			return false;
+		}
+
+		int touched[] = { n[p - 1], n[p + 1], m[q - 1], m[q + 1], v };
+		a.Nodes[p] = v;
+		b.Nodes[q] = u;
+		Rebuild(uRoute);
+		Rebuild(vRoute);
+		for (int city : touched)
+		{
+			Activate(city);
+		}
+	}
+	else
+	{
+		Route& route = mRoutes[uRoute];
+		const std::vector<int>& n = route.Nodes;
+		int p = std::min(mPositionOf[u], mPositionOf[v]);
+		int q = std::max(mPositionOf[u], mPositionOf[v]);
+		int x = n[p];
+		int y = n[q];
+		int length = mLengths[uRoute];
+		if (q == p + 1)
+		{
+			length += -distances(n[p - 1], x) - distances(x, y) - distances(y, n[q + 1]) + distances(n[p - 1], y) + distances(y, x) + distances(x, n[q + 1]);
+		}
+		else
+		{
+			length += -distances(n[p - 1], x) - distances(x, n[p + 1]) - distances(n[q - 1], y) - distances(y, n[q + 1])
+				+ distances(n[p - 1], y) + distances(y, n[p + 1]) + distances(n[q - 1], x) + distances(x, n[q + 1]);
+		}
+		int warp = 0;
+		if (mTimeWindows != nullptr)
+		{
+			TimeSegment segment = Join(route.Prefix[p - 1], n[p - 1], TimeSegment::Visit(mTimeWindows[y]), y);
+			int last = y;
+			if (q > p + 1)
+			{
+				segment = Join(segment, y, Path(route, p + 1, q - 1), n[p + 1]);
+				last = n[q - 1];
+			}
+			segment = Join(Join(segment, last, TimeSegment::Visit(mTimeWindows[x]), x), x, route.Suffix[q + 1], n[q + 1]);
+			warp = segment.TimeWarp;
+		}
+		fitness = Score(uRoute, length, mLoads[uRoute], warp, -1, 0, 0, 0);
+		if (fitness >= mFitness)
+		{
+			return false;
+		}
+
+		int touched[] = { n[p - 1], n[p + 1], n[q - 1], n[q + 1], v };
+		std::swap(route.Nodes[p], route.Nodes[q]);
+		Rebuild(uRoute);
+		for (int city : touched)
+		{
+			Activate(city);
+		}
+	}
+	mFitness = fitness;
+	return true;
+}
+
+// Reverses the part of the route behind the first of u and v up to the second one, so u and v become neighbours
+bool LocalSearch::TwoOpt(int u, int v)
+{
+	const DistanceOracle& distances = *mDistances;
+	const int r = mRouteOf[u];
+	Route& route = mRoutes[r];
+	const std::vector<int>& n = route.Nodes;
+	int p = std::min(mPositionOf[u], mPositionOf[v]);
+	int q = std::max(mPositionOf[u], mPositionOf[v]);
+	if (q <= p + 1)
+	{
+		return false;
+	}
+
+	// The reversed part is travelled backwards, Backward holds its length for asymmetric distances
+	int length = mLengths[r] - distances(n[p], n[p + 1]) - (route.Forward[q] - route.Forward[p + 1]) - distances(n[q], n[q + 1])
+		+ distances(n[p], n[q]) + (route.Backward[q] - route.Backward[p + 1]) + distances(n[p + 1], n[q + 1]);
+	int warp = 0;
+	if (mTimeWindows != nullptr)
+	{
+		TimeSegment segment = Join(route.Prefix[p], n[p], Path(route, q, p + 1), n[q]);
+		warp = Join(segment, n[p + 1], route.Suffix[q + 1], n[q + 1]).TimeWarp;
+	}
+	int fitness = Score(r, length, mLoads[r], warp, -1, 0, 0, 0);
+	if (fitness >= mFitness)
+	{
+		return false;
+	}
+
+	int touched[] = { n[p], n[p + 1], n[q], n[q + 1] };
+	std::reverse(route.Nodes.begin() + p + 1, route.Nodes.begin() + q + 1);
+	Rebuild(r);
+	for (int city : touched)
+	{
+		Activate(city);
+	}
+	mFitness = fitness;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "DistanceOracle.h"
+#include "NeighbourIndex.h"
+#include "Random.h"
+#include "TimeWindow.h"
+
+class GeneticAlgorithm;
+
+// Memetic improvement of one individual with intra-route 2-opt, relocate of chains with up to three customers
+// (relocate and or-opt, within and between routes) and exchange of two customers.
+// Moves are only tried between a customer and its nearest neighbours (granular neighbourhood), a customer without
+// an improving move is skipped until a move changes its surroundings (don't-look bits).
+// Distance and load of a move are evaluated in O(1) out of prefix sums of every route, time windows out of the
+// forward and backward time segments (O(1) between routes, O(route length) within a route).
+// Route lengths include the return of the last vehicle, the individual is evaluated by the GA afterwards
+class LocalSearch
+{
+public:
+	LocalSearch();
+
+	// Takes the distances and neighbour index of ga, has to be called before Improve and after the input changed
+	void Setup(const GeneticAlgorithm& ga);
+
+	// Applies improving moves until there is none left, returns false if individual has an empty route
+	bool Improve(int* individual, Xoshiro256& random);
+
+private:
+	struct Route
+	{
+		std::vector<int>			Nodes;		// Depot, customers, depot
+		std::vector<int>			Forward;	// Distance from the start to every position
+		std::vector<int>			Backward;	// Distance of the reversed route from every position to the start
+		std::vector<int>			Load;		// Demand of the customers up to every position
+		std::vector<TimeSegment>	Prefix;		// Start to every position, only with time windows
+		std::vector<TimeSegment>	Suffix;		// Every position to the end, only with time windows
+
+		int Size() const { return static_cast<int>(Nodes.size()) - 2; }
+	};
+
+	const GeneticAlgorithm*	mGa;
+	const DistanceOracle*	mDistances;
+	const int*				mDemands;		// nullptr without demands
+	const TimeWindow*		mTimeWindows;	// nullptr without time windows
+	const NeighbourIndex*	mNeighbours;	// Candidates of every city, nearest first
+
+	int						mDepot;
+	int						mFitness;		// Fitness of the routes, same scoring as the GA
+	std::vector<Route>		mRoutes;
+	std::vector<int>		mRouteOf;		// Route of every customer
+	std::vector<int>		mPositionOf;	// Position of every customer in Route::Nodes
+	std::vector<int>		mLengths;
+	std::vector<int>		mLoads;
+	std::vector<int>		mWarps;
+	std::vector<char>		mDontLook;
+	std::vector<int>		mOrder;			// Customers in random order
+
+	void Rebuild(int route);
+	int Score(int first, int firstLength, int firstLoad, int firstWarp, int second, int secondLength, int secondLoad, int secondWarp);
+	TimeSegment Path(const Route& route, int from, int to) const;
+	TimeSegment Join(const TimeSegment& segment, int last, const TimeSegment& next, int first) const;
+	void Activate(int city);
+
+	bool ImproveCustomer(int u);
+	bool Relocate(int fromRoute, int first, int last, int toRoute, int after);
+	bool Exchange(int u, int v);
+	bool TwoOpt(int u, int v);
+};
\ No newline at end of file
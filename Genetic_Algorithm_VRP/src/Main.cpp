@@ -5,11 +5,18 @@
 #include <random>
 #include <omp.h>
 #include <thread>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <algorithm>
 
 #include "ArgumentParser.h"
+#include "Benchmark.h"
 #include "Genetic.h"
 #include "GraphDrawer.h"
-#include "Timing.h"
+#include "IslandScheduler.h"
+#include "Profiler.h"
+#include "Util.h"
 
 #ifdef _WIN32
 const std::string sPrefix = "../";
@@ -20,61 +27,380 @@ const std::string sPrefix;
 //const std::string sInputFile = "Data/Romania.txt";
 const std::string sInputFile = "Data/US.txt";
 
+std::string InputFile = sPrefix + sInputFile;
 int NumThreads = 4;
+int IslandThreads = 1;
+int NumIslands = 4;
+int SliceGenerations = 10;
 bool VisualMode = false;
+GeneticAlgorithm::InversionMode Inversion = GeneticAlgorithm::InversionMode::Fenwick;
+GeneticAlgorithm::Representation Representation = GeneticAlgorithm::Representation::Separators;
+uint64_t Seed = 0U;
+MigrationHub::Topology Topology = MigrationHub::Topology::Ring;
+int MigrationInterval = 500;
+int NumMigrants = 5;
+bool SyncMigration = false;
+int TargetFitness = -1;
+int Iterations = 100000;
+double TimeLimit = 0.0;
+int MaxStagnation = 0;
+bool ScalingReport = false;
+bool ProfileSummary = false;
+std::string TraceFile;
+std::string BenchmarkName;
+int BenchmarkSize = 0;
+bool UseDistanceCache = true;
+bool VerifyDistanceCache = false;
+DistanceOracle::Metric Metric = DistanceOracle::Metric::Matrix;
+int Vehicles = GeneticAlgorithm::sDefaultVehicles;
+int Capacity = -1;
+int CapacityPenalty = 100;
+int TimeWarpPenalty = 100;
+double LocalSearchRate = 0.0;
+double HeuristicFraction = 0.0;
+int NumNeighbours = 10;
+NeighbourIndex::Direction NeighbourDirection = NeighbourIndex::Direction::Outgoing;
 
 void LoadArguments(int argc, char** argv)
 {
 	ArgumentParser parser(argc, argv);
 
+	InputFile = parser.GetString("-f", "--file", InputFile);	// Prolog facts, TSPLIB/CVRPLIB instance or plain distance matrix, detected automatically
 	NumThreads = parser.GetInt("-t", "--threads", std::thread::hardware_concurrency());	// Get number of allowed threads, default is maximum number of threads
 	VisualMode = parser.CheckIfExists("-v", "--visual");	// Check if visual output should be shown (Only available on Windows x64)
+	omp_set_num_threads(NumThreads);	// Also used for parallel loading
 
-	std::cout << "Using Threads: " << NumThreads << std::endl << std::endl;
+	// Threads inside every island for breeding, mutation and evaluation of one generation, they run as nested teams
+	IslandThreads = parser.GetInt("", "--island-threads", 1);
+	if (IslandThreads < 1)
+	{
+		std::cout << "Invalid number of island threads " << IslandThreads << ", using 1" << std::endl;
+		IslandThreads = 1;
+	}
+	if (IslandThreads > 1)
+	{
+		omp_set_max_active_levels(2);
+	}
+
+	// Islands are time-sliced on the threads, every task runs SliceGenerations generations of one island
+	NumIslands = parser.GetInt("", "--islands", NumThreads);	// Number of islands, default is one per thread
+	if (NumIslands < 1)
+	{
+		std::cout << "Invalid number of islands " << NumIslands << ", using " << NumThreads << std::endl;
+		NumIslands = NumThreads;
+	}
+	SliceGenerations = parser.GetInt("", "--slice-generations", SliceGenerations);
+
+	std::string inversion = parser.GetString("", "--inversion", "fenwick");	// Inversion sequence implementation: fenwick, legacy or verify (runs both and compares)
+	if (inversion == "legacy")
+	{
+		Inversion = GeneticAlgorithm::InversionMode::Legacy;
+	}
+	else if (inversion == "verify")
+	{
+		Inversion = GeneticAlgorithm::InversionMode::Verify;
+	}
+
+	// Chromosome encoding: separators (blanks between the routes) or giant-tour (order only, routes cut by Split)
+	std::string representation = parser.GetString("", "--representation", "separators");
+	if (representation == "giant-tour")
+	{
+		Representation = GeneticAlgorithm::Representation::GiantTour;
+	}
+	else if (representation != "separators")
+	{
+		std::cout << "Unknown representation " << representation << ", using separators" << std::endl;
+	}
+
+	// Seed of the random streams, same seed and thread count reproduce the same result
+	Seed = parser.GetUInt64("", "--seed", (uint64_t(std::random_device{}()) << 32) | std::random_device{}());
+
+	// Island model: islands exchange their best individuals every MigrationInterval generations (0 disables migration)
+	std::string topology = parser.GetString("", "--topology", "ring");	// ring, full or random
+	if (!MigrationHub::ParseTopology(topology, Topology))
+	{
+		std::cout << "Unknown topology " << topology << ", using ring" << std::endl;
+	}
+	MigrationInterval = parser.GetInt("", "--migration-interval", MigrationInterval);
+	NumMigrants = parser.GetInt("", "--migrants", NumMigrants);
+	SyncMigration = parser.CheckIfExists("", "--sync-migration");	// Islands wait for each other at every migration, reproducible with --seed
+
+	// Stop criteria, the first one that is met ends the run
+	Iterations = parser.GetInt("-i", "--iterations", Iterations);	// Maximum number of generations
+	TimeLimit = parser.GetFloat("", "--time-limit", 0.0f);	// Wall-clock budget in ms, 0 means no limit
+	MaxStagnation = parser.GetInt("", "--max-stagnation", 0);	// Generations without improvement until an island stops, 0 means no limit
+	TargetFitness = parser.GetInt("", "--target-fitness", TargetFitness);	// Fitness that counts as good enough, stops all islands
+	ScalingReport = parser.CheckIfExists("", "--scaling");	// Report time-to-target for 1, 2, 4, ... threads
+
+	// Profiler output, only available if built with PROFILE=1
+	ProfileSummary = parser.CheckIfExists("", "--profile");	// Print time per phase
+	TraceFile = parser.GetString("", "--trace", "");	// Write Chrome trace-event JSON (chrome://tracing, Perfetto)
+	if ((ProfileSummary || !TraceFile.empty()) && !Profiler::IsEnabled())
+	{
+		std::cout << "Profiler is not compiled in, build with PROFILE=1 (ENABLE_PROFILER)" << std::endl;
+	}
+
+	UseDistanceCache = !parser.CheckIfExists("", "--no-cache");	// Always recompute the distance matrix, no cache file is read or written
+	VerifyDistanceCache = parser.CheckIfExists("", "--verify-cache");	// Hash the whole cache file before it is used, reads all of the matrix
+
+	// Capacitated VRP, a capacity of 0 disables the capacity term
+	Capacity = parser.GetInt("", "--capacity", -1);	// Capacity of every vehicle, overrides the CAPACITY of the input
+	CapacityPenalty = parser.GetInt("", "--capacity-penalty", CapacityPenalty);	// Fitness penalty per unit of load above the capacity
+	TimeWarpPenalty = parser.GetInt("", "--time-warp-penalty", TimeWarpPenalty);	// Fitness penalty per unit of lateness, only for inputs with time windows
+
+	// Construction heuristics seed the initial population, the rest of it is random
+	HeuristicFraction = parser.GetFloat("", "--heuristic-fraction", 0.0f);	// Part of the initial population built by nearest neighbour, savings and sweep
+
+	// Memetic local search on the offspring, moves are only tried between a customer and its nearest neighbours
+	LocalSearchRate = parser.GetFloat("", "--local-search", 0.0f);	// Probability that an offspring is improved, 0 disables the local search
+	NumNeighbours = parser.GetInt("", "--neighbours", NumNeighbours);	// Candidates per customer, 0 builds no neighbour index
+	if (LocalSearchRate > 0.0 && NumNeighbours < 1)
+	{
+		std::cout << "Local search needs neighbours, using 10" << std::endl;
+		NumNeighbours = 10;
+	}
+	std::string direction = parser.GetString("", "--neighbour-direction", "outgoing");	// outgoing or both (shorter direction of an asymmetric matrix)
+	if (!NeighbourIndex::ParseDirection(direction, NeighbourDirection))
+	{
+		std::cout << "Unknown neighbour direction " << direction << ", using outgoing" << std::endl;
+	}
+
+	Vehicles = parser.GetInt("", "--vehicles", Vehicles);	// Number of routes of a solution, 2 to 16 use specialized kernels
+	if (Vehicles < 1)
+	{
+		std::cout << "Invalid number of vehicles " << Vehicles << ", using " << GeneticAlgorithm::sDefaultVehicles << std::endl;
+		Vehicles = GeneticAlgorithm::sDefaultVehicles;
+	}
+
+	// Dense matrix or distances computed from the coordinates on demand (O(N) memory)
+	std::string metric = parser.GetString("", "--distances", "matrix");
+	if (!DistanceOracle::ParseMetric(metric, Metric))
+	{
+		std::cout << "Unknown distance mode " << metric << ", using matrix" << std::endl;
+	}
+
+	// Runs a micro-benchmark instead of the solver
+	BenchmarkName = parser.GetString("", "--benchmark", "");
+	BenchmarkSize = parser.GetInt("", "--benchmark-size", 0);	// Problem size of the benchmark, 0 uses its default
+
+	std::cout << "Using Input: " << InputFile << std::endl;
+	std::cout << "Using Threads: " << NumThreads << std::endl;
+	if (NumIslands != NumThreads)
+	{
+		std::cout << "Using Islands: " << NumIslands << std::endl;
+	}
+	if (IslandThreads > 1)
+	{
+		std::cout << "Using Island Threads: " << IslandThreads << std::endl;
+	}
+	std::cout << "Using Seed: " << Seed << std::endl;
+	if (MigrationInterval > 0)
+	{
+		std::cout << "Using Migration: " << MigrationHub::TopologyName(Topology) << ", " << NumMigrants << " migrants every " << MigrationInterval << " generations"
+			<< (SyncMigration ? ", synchronous" : "") << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+// Index of the island with the best solution, -1 if all islands were stopped before they started and none has one
+int FindBest(const std::vector<GeneticAlgorithm*>& algos)
+{
+	int bestFitness = INT32_MAX;
+	int bestIndex = -1;
+	for (size_t i = 0; i < algos.size(); i++)
+	{
+		int fitness = algos[i]->GetBestFitness();
+		if (algos[i]->GetBest() != nullptr && (bestIndex < 0 || fitness < bestFitness))
+		{
+			bestFitness = fitness;
+			bestIndex = static_cast<int>(i);
+		}
+	}
+	return bestIndex;
+}
+
+void DeleteIslands(std::vector<GeneticAlgorithm*>& algos)
+{
+	for (auto* algo : algos)
+	{
+		delete algo;
+	}
+	algos.clear();
+}
+
+// Fills algos up to numIslands copies of algos[0] and solves all of them on numThreads threads.
+// Returns the index of the island with the best solution, -1 if there is none
+int RunIslands(std::vector<GeneticAlgorithm*>& algos, int numIslands, int numThreads)
+{
+	// Copy object with parsed input, the distance matrix is shared and not copied
+	for (int i = static_cast<int>(algos.size()); i < numIslands; i++)
+	{
+		algos.push_back(new GeneticAlgorithm(*algos[0]));
+	}
+
+	std::shared_ptr<MigrationHub> migration;
+	if (MigrationInterval > 0 && numIslands > 1)
+	{
+		migration = std::make_shared<MigrationHub>(numIslands, Topology, MigrationInterval, NumMigrants, SyncMigration);
+	}
+
+	// Stops all islands as soon as one reaches the target or the time is up
+	auto stop = std::make_shared<std::atomic<bool>>(false);
+
+	// Every island gets its own, non-overlapping random stream. The clock of the time limit starts for all islands now,
+	// also for those that wait in the scheduler until a thread is free
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < numIslands; i++)
+	{
+		algos[i]->SetSeed(Seed, i);
+		algos[i]->SetMigration(migration, i);
+		algos[i]->SetStopFlag(stop);
+		algos[i]->SetRunStart(start);
+	}
+
+	IslandScheduler scheduler(numThreads, SliceGenerations);
+	for (int i = 0; i < numIslands; i++)
+	{
+		scheduler.Spawn(algos[i]);
+	}
+	scheduler.Wait();
+	return FindBest(algos);
+}
+
+// Earliest time an island reached the target fitness, -1 if none did
+double TimeToTarget(const std::vector<GeneticAlgorithm*>& algos)
+{
+	double time = -1.0;
+	for (const auto* algo : algos)
+	{
+		if (algo->GetTimeToTarget() >= 0.0 && (time < 0.0 || algo->GetTimeToTarget() < time))
+		{
+			time = algo->GetTimeToTarget();
+		}
+	}
+	return time;
+}
+
+// Solves with 1, 2, 4, ... NumThreads islands and prints time-to-target and quality of each run
+void PrintScalingReport(const GeneticAlgorithm& prototype)
+{
+	std::cout << "Threads\tTime to target [ms]\tBest fitness\tTotal [ms]" << std::endl;
+	for (int threads = 1; threads <= NumThreads; threads = (threads * 2 > NumThreads && threads != NumThreads) ? NumThreads : threads * 2)
+	{
+		std::vector<GeneticAlgorithm*> algos;
+		algos.push_back(new GeneticAlgorithm(prototype));
+
+		auto start = std::chrono::steady_clock::now();
+		int bestIndex = RunIslands(algos, threads, threads);
+		double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		double timeToTarget = TimeToTarget(algos);
+		std::cout << threads << "\t" << (timeToTarget >= 0.0 ? std::to_string(timeToTarget) : "not reached") << "\t"
+			<< (bestIndex >= 0 ? std::to_string(algos[bestIndex]->GetBestFitness()) : "none") << "\t" << total << std::endl;
+
+		DeleteIslands(algos);
+	}
 }
 
 int main(int argc, char** argv)
 {
 	LoadArguments(argc, argv);
 
+	if (!BenchmarkName.empty())
+	{
+		return Benchmark::Run(BenchmarkName, InputFile, BenchmarkSize) ? 0 : 1;
+	}
+
 	std::vector<GeneticAlgorithm*> algos;
 
 	// Create default object and read file one time, then copy
 	algos.push_back(new GeneticAlgorithm());
-	algos[0]->ReadFile(sPrefix + sInputFile, true);
-
-	// Copy object with parsed input
-	for (int i = 1; i < NumThreads; i++)
+	algos[0]->mUseDistanceCache = UseDistanceCache;
+	algos[0]->mVerifyDistanceCache = VerifyDistanceCache;
+	algos[0]->mMetric = Metric;
+	algos[0]->mNumNeighbours = NumNeighbours;
+	algos[0]->mNeighbourDirection = NeighbourDirection;
+	algos[0]->mLocalSearchRate = LocalSearchRate;		// Both decide whether ReadFile builds the neighbour index
+	algos[0]->mHeuristicFraction = HeuristicFraction;
+	algos[0]->SetVehicles(Vehicles);
+	if (!algos[0]->ReadFile(InputFile, true))
 	{
-		algos.push_back(new GeneticAlgorithm(*algos[0]));
+		std::cout << "Could not read " << InputFile << std::endl;
+		delete algos[0];
+		return 1;
+	}
+	if (Capacity >= 0)
+	{
+		algos[0]->mCapacity = Capacity;
 	}
-	Timing::getInstance()->startComputation();
-#pragma omp parallel for
-	for (int i = 0; i < NumThreads; i++)
+	algos[0]->mCapacityPenalty = CapacityPenalty;
+	algos[0]->mTimeWarpPenalty = TimeWarpPenalty;
+	algos[0]->mInversionMode = Inversion;
+	algos[0]->mRepresentation = Representation;
+	algos[0]->mIslandThreads = IslandThreads;
+	algos[0]->mTargetFitness = TargetFitness;
+	algos[0]->mIterations = Iterations;
+	algos[0]->mTimeLimit = TimeLimit;
+	algos[0]->mMaxStagnation = MaxStagnation;
+
+	if (ScalingReport)
 	{
-		// Start needed threads
-		//std::cout << "Started Thread " << std::to_string(i) << std::endl;
-		algos[i]->SolveVRP();
+		PrintScalingReport(*algos[0]);
+		delete algos[0];
+		return 0;
 	}
-	Timing::getInstance()->stopComputation();
 
-	std::cout << "Calculated " << algos[0]->mIterations << " iterations in ";
-	Timing::getInstance()->print(true);
+	auto start = std::chrono::steady_clock::now();
+	int bestIndex = RunIslands(algos, NumIslands, NumThreads);
+	double computation = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int generations = 0;
+	for (const auto* algo : algos)
+	{
+		generations = std::max(generations, algo->GetGenerations());
+	}
+	std::cout << "Calculated " << generations << " iterations in " << Util::FormatDuration(static_cast<int>(computation)) << std::endl;
 	std::cout << std::endl;
 
-	// Find best solution in all started threads
-	int bestFitness = INT32_MAX;
-	int bestIndex = 0;
-	for (int i = 0; i < NumThreads; i++)
+	if (ProfileSummary && Profiler::IsEnabled())
 	{
-		int fitness = algos[i]->EvaluateFitness(algos[i]->GetBest());
-		if (fitness < bestFitness)
+		Profiler::PrintSummary();
+		std::cout << std::endl;
+	}
+	if (!TraceFile.empty() && Profiler::IsEnabled())
+	{
+		if (Profiler::WriteChromeTrace(TraceFile))
 		{
-			bestFitness = fitness;
-			bestIndex = i;
+			std::cout << "Trace written to " << TraceFile << std::endl << std::endl;
+		}
+		else
+		{
+			std::cout << "Could not write trace to " << TraceFile << std::endl << std::endl;
+		}
+	}
+
+	if (TargetFitness >= 0)
+	{
+		double timeToTarget = TimeToTarget(algos);
+		if (timeToTarget >= 0.0)
+		{
+			std::cout << "Reached target fitness " << TargetFitness << " after " << timeToTarget << "ms" << std::endl;
+		}
+		else
+		{
+			std::cout << "Target fitness " << TargetFitness << " not reached" << std::endl;
 		}
 	}
 
+	// Every island was stopped or killed before it started, none has a solution
+	if (bestIndex < 0)
+	{
+		std::cout << "No island has a solution, all were stopped before they started" << std::endl;
+		DeleteIslands(algos);
+		Profiler::Clear();
+		return 1;
+	}
+
 	int* solution = algos[bestIndex]->GetBest();
 
 	std::cout << "Best solution found in Thread: " << bestIndex << std::endl;
@@ -124,12 +450,8 @@ int main(int argc, char** argv)
 	}
 
 	// Cleanup
-	for (size_t i = 0; i < algos.size(); i++)
-	{
-		delete algos[i];
-	}
-	algos.clear();
-	Timing::getInstance()->clear();
+	DeleteIslands(algos);
+	Profiler::Clear();
 	return 0;
 }
 
@@ -0,0 +1,127 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: mData(nullptr)
+	, mSize(0U)
+	, mIsOpen(false)
+#ifdef _WIN32
+	, mFile(nullptr)
+	, mMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path, bool sequential)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	mFile = file;
+	mSize = static_cast<size_t>(size.QuadPart);
+	mIsOpen = true;
+
+	// Mapping an empty file is not possible
+	if (mSize == 0U)
+	{
+		return true;
+	}
+	mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping != nullptr)
+	{
+		mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close(file);
+		return false;
+	}
+	mSize = static_cast<size_t>(info.st_size);
+	mIsOpen = true;
+
+	// Mapping an empty file is not possible
+	if (mSize != 0U)
+	{
+		void* data = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, file, 0);
+		if (data != MAP_FAILED)
+		{
+			mData = static_cast<const char*>(data);
+			if (sequential)
+			{
+				madvise(data, mSize, MADV_SEQUENTIAL);
+			}
+		}
+	}
+	// The mapping stays valid without the descriptor
+	close(file);
+#endif
+
+	if (mSize != 0U && mData == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (mData != nullptr)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping != nullptr)
+	{
+		CloseHandle(mMapping);
+	}
+	if (mFile != nullptr)
+	{
+		CloseHandle(mFile);
+	}
+	mMapping = nullptr;
+	mFile = nullptr;
+#else
+	if (mData != nullptr)
+	{
+		munmap(const_cast<char*>(mData), mSize);
+	}
+#endif
+	mData = nullptr;
+	mSize = 0U;
+	mIsOpen = false;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The pages come from the OS page cache,
+// so nothing is copied and concurrent processes share them.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// sequential hints the OS to read ahead aggressively, for files that are scanned once
+	bool Open(const std::string& path, bool sequential = false);
+	void Close();
+
+	bool IsOpen() const { return mIsOpen; }
+	const char* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+
+private:
+	const char*	mData;		// Start of the mapping, nullptr for empty files
+	size_t		mSize;		// Size of the file in bytes
+	bool		mIsOpen;	// Open succeeded (also true for empty files)
+#ifdef _WIN32
+	void*		mFile;		// File and mapping handles
+	void*		mMapping;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include <random>
+
+#include "Migration.h"
+
+MigrationHub::MigrationHub(int numIslands, Topology topology, int interval, int numMigrants, bool synchronous)
+	: mNumIslands(numIslands)
+	, mTopology(topology)
+	, mInterval(interval)
+	, mNumMigrants(numMigrants)
+	, mSynchronous(synchronous)
+	, mSlots(new std::atomic<Packet*>[static_cast<size_t>(numIslands) * numIslands])
+	, mLeft(new std::atomic<bool>[numIslands])
+{
+	for (int i = 0; i < mNumIslands * mNumIslands; i++)
+	{
+		mSlots[i].store(nullptr, std::memory_order_relaxed);
+	}
+	for (int i = 0; i < mNumIslands; i++)
+	{
+		if (mSynchronous)
+		{
+			mMailboxes.push_back(std::make_unique<Mailbox>());
+			mMailboxes.back()->Senders.resize(mNumIslands);
+		}
+		mLeft[i].store(false, std::memory_order_relaxed);
+	}
+}
+
+MigrationHub::~MigrationHub()
+{
+	for (int i = 0; i < mNumIslands * mNumIslands; i++)
+	{
+		delete mSlots[i].exchange(nullptr, std::memory_order_acquire);
+	}
+}
+
+void MigrationHub::Send(int from, const Packet& packet, Xoshiro256& random)
+{
+	if (mNumIslands < 2)
+	{
+		return;
+	}
+
+	switch (mTopology)
+	{
+	case Topology::Ring:
+		Deliver(from, (from + 1) % mNumIslands, packet);
+		break;
+	case Topology::FullyConnected:
+		for (int to = 0; to < mNumIslands; to++)
+		{
+			if (to != from)
+			{
+				Deliver(from, to, packet);
+			}
+		}
+		break;
+	case Topology::Random:
+	{
+		// Pick any island but the sender, if synchronous the others are told that nothing comes in this exchange
+		std::uniform_int_distribution<int> distribution(0, mNumIslands - 2);
+		int chosen = distribution(random);
+		chosen = chosen >= from ? chosen + 1 : chosen;
+		if (!mSynchronous)
+		{
+			Deliver(from, chosen, packet);
+			break;
+		}
+		Packet empty{ {}, 0, packet.Exchange };
+		for (int to = 0; to < mNumIslands; to++)
+		{
+			if (to != from)
+			{
+				Deliver(from, to, to == chosen ? packet : empty);
+			}
+		}
+		break;
+	}
+	}
+}
+
+bool MigrationHub::Receive(int to, std::vector<std::unique_ptr<Packet>>& packets)
+{
+	bool received = false;
+	for (int from = 0; from < mNumIslands; from++)
+	{
+		Packet* packet = mSlots[to * mNumIslands + from].exchange(nullptr, std::memory_order_acquire);
+		if (packet != nullptr)
+		{
+			packets.emplace_back(packet);
+			received = true;
+		}
+	}
+	return received;
+}
+
+bool MigrationHub::Receive(int to, int exchange, std::vector<std::unique_ptr<Packet>>& packets)
+{
+	Mailbox& mailbox = *mMailboxes[to];
+	std::lock_guard<std::mutex> lock(mailbox.Mutex);
+
+	// A neighbour that left after its last packet was queued first, so an empty queue of a left neighbour stays empty
+	for (int from = 0; from < mNumIslands; from++)
+	{
+		if (IsNeighbour(from, to) && mailbox.Senders[from].empty() && !mLeft[from].load(std::memory_order_acquire))
+		{
+			return false;
+		}
+	}
+	for (int from = 0; from < mNumIslands; from++)
+	{
+		auto& queue = mailbox.Senders[from];
+		if (!queue.empty() && queue.front()->Exchange == exchange)
+		{
+			packets.push_back(std::move(queue.front()));
+			queue.pop_front();
+		}
+	}
+	return true;
+}
+
+void MigrationHub::Leave(int from)
+{
+	mLeft[from].store(true, std::memory_order_release);
+}
+
+void MigrationHub::Deliver(int from, int to, const Packet& packet)
+{
+	if (!mSynchronous)
+	{
+		// Replace the packet in the slot, a packet the receiver did not collect yet is outdated and dropped
+		Packet* old = mSlots[to * mNumIslands + from].exchange(new Packet(packet), std::memory_order_acq_rel);
+		delete old;
+		return;
+	}
+
+	Mailbox& mailbox = *mMailboxes[to];
+	std::lock_guard<std::mutex> lock(mailbox.Mutex);
+	mailbox.Senders[from].push_back(std::make_unique<Packet>(packet));
+}
+
+bool MigrationHub::IsNeighbour(int from, int to) const
+{
+	if (from == to)
+	{
+		return false;
+	}
+	return mTopology != Topology::Ring || to == (from + 1) % mNumIslands;
+}
+
+bool MigrationHub::ParseTopology(const std::string& name, Topology& topology)
+{
+	if (name == "ring")
+	{
+		topology = Topology::Ring;
+	}
+	else if (name == "full")
+	{
+		topology = Topology::FullyConnected;
+	}
+	else if (name == "random")
+	{
+		topology = Topology::Random;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+std::string MigrationHub::TopologyName(Topology topology)
+{
+	switch (topology)
+	{
+	case Topology::Ring:
+		return "ring";
+	case Topology::FullyConnected:
+		return "full";
+	case Topology::Random:
+		return "random";
+	}
+	return "";
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+
+// Exchanges individuals between islands (one GeneticAlgorithm each).
+// By default every island has a mailbox with one slot per sending island. Packets are swapped in and out of the slots
+// atomically, so sending and receiving never blocks and a slow island never holds up a fast one. If a packet was not
+// collected before the next one arrives, the old one is dropped.
+// Synchronous migration happens in numbered exchanges instead: the mailbox has one queue per sender and a receiver only
+// takes the packets of an exchange once every neighbour has sent (or left). Which migrants arrive then does not depend
+// on the thread timing and a run with a fixed seed is reproducible, but every island waits for its slowest neighbour.
+class MigrationHub
+{
+public:
+	enum class Topology
+	{
+		Ring,			// Island i sends to island i + 1
+		FullyConnected,	// Every island sends to all other islands
+		Random			// Every island sends to one randomly chosen island (the others get an empty packet if synchronous)
+	};
+
+	struct Packet
+	{
+		std::vector<int>	Routes;		// Chromosomes of all migrants, back to back
+		int					Count;		// Number of migrants in Routes
+		int					Exchange;	// Number of the exchange, counted from 1
+	};
+
+	MigrationHub(int numIslands, Topology topology, int interval, int numMigrants, bool synchronous);
+	~MigrationHub();
+
+	MigrationHub(const MigrationHub&) = delete;
+	MigrationHub& operator=(const MigrationHub&) = delete;
+
+	// Sends a copy of packet to all neighbours of island from. If synchronous, an island sends once per exchange in order
+	void Send(int from, const Packet& packet, Xoshiro256& random);
+
+	// Takes all packets that arrived for island to since the last call, returns false if there were none.
+	// Never blocks, only without synchronous migration
+	bool Receive(int to, std::vector<std::unique_ptr<Packet>>& packets);
+
+	// Synchronous migration: takes the packets of an exchange for island to if all of them arrived, returns false
+	// (and takes nothing) otherwise. Neighbours that left are not waited for
+	bool Receive(int to, int exchange, std::vector<std::unique_ptr<Packet>>& packets);
+
+	// Island from sends no more packets, called when its run ends
+	void Leave(int from);
+
+	int NumIslands() const { return mNumIslands; }
+	int Interval() const { return mInterval; }
+	int NumMigrants() const { return mNumMigrants; }
+	bool IsSynchronous() const { return mSynchronous; }
+	Topology GetTopology() const { return mTopology; }
+
+	// Parses ring, full or random, returns false on unknown names
+	static bool ParseTopology(const std::string& name, Topology& topology);
+	static std::string TopologyName(Topology topology);
+
+private:
+	struct Mailbox
+	{
+		std::mutex	Mutex;
+		std::vector<std::deque<std::unique_ptr<Packet>>>	Senders;	// Packets not taken yet per sending island, oldest first
+	};
+
+	void Deliver(int from, int to, const Packet& packet);
+	bool IsNeighbour(int from, int to) const;
+
+	int			mNumIslands;
+	Topology	mTopology;
+	int			mInterval;		// Generations between two migrations
+	int			mNumMigrants;	// Individuals sent per migration
+	bool		mSynchronous;	// Exchanges wait for all neighbours
+
+	std::unique_ptr<std::atomic<Packet*>[]> mSlots;	// Slot of sender from in the mailbox of to: [to * mNumIslands + from]
+	std::vector<std::unique_ptr<Mailbox>>	mMailboxes;	// One per receiving island, only if synchronous
+	std::unique_ptr<std::atomic<bool>[]>	mLeft;		// Islands that send no more packets
+};
\ No newline at end of file
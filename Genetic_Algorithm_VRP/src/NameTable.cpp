@@ -0,0 +1,83 @@
+#include "NameTable.h"
+
+NameTable::NameTable(size_t expectedNames)
+{
+	size_t capacity = 16U;
+	while (capacity < expectedNames * 2U)
+	{
+		capacity *= 2U;
+	}
+	mSlots.assign(capacity, Slot{ 0U, -1 });
+	mMask = capacity - 1U;
+	mNames.reserve(expectedNames);
+}
+
+uint64_t NameTable::Hash(std::string_view name)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : name)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+int NameTable::Find(std::string_view name) const
+{
+	uint64_t hash = Hash(name);
+	for (size_t i = hash & mMask; ; i = (i + 1U) & mMask)
+	{
+		const Slot& slot = mSlots[i];
+		if (slot.Id < 0)
+		{
+			return -1;
+		}
+		if (slot.Hash == hash && mNames[slot.Id] == name)
+		{
+			return slot.Id;
+		}
+	}
+}
+
+int NameTable::Insert(std::string_view name)
+{
+	uint64_t hash = Hash(name);
+	size_t i = hash & mMask;
+	for (; mSlots[i].Id >= 0; i = (i + 1U) & mMask)
+	{
+		if (mSlots[i].Hash == hash && mNames[mSlots[i].Id] == name)
+		{
+			return mSlots[i].Id;
+		}
+	}
+
+	int id = Size();
+	mSlots[i] = Slot{ hash, id };
+	mNames.push_back(name);
+	if (mNames.size() * 2U > mSlots.size())
+	{
+		Grow();
+	}
+	return id;
+}
+
+void NameTable::Grow()
+{
+	std::vector<Slot> slots(mSlots.size() * 2U, Slot{ 0U, -1 });
+	mMask = slots.size() - 1U;
+	for (const Slot& slot : mSlots)
+	{
+		if (slot.Id >= 0)
+		{
+			size_t i = slot.Hash & mMask;
+			while (slots[i].Id >= 0)
+			{
+				i = (i + 1U) & mMask;
+			}
+			slots[i] = slot;
+		}
+	}
+	mSlots.swap(slots);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Flat open-addressing hash table that interns names to consecutive ids.
+// Keys are views, the memory they point to has to outlive the table.
+class NameTable
+{
+public:
+	explicit NameTable(size_t expectedNames = 64U);
+
+	// Id of name, -1 if it was never inserted
+	int Find(std::string_view name) const;
+
+	// Returns the id of name, a new id (Size() before the call) if it wasn't known yet
+	int Insert(std::string_view name);
+
+	int Size() const { return static_cast<int>(mNames.size()); }
+	std::string_view Name(int id) const { return mNames[id]; }
+
+	static uint64_t Hash(std::string_view name);
+
+private:
+	struct Slot
+	{
+		uint64_t	Hash;
+		int			Id;		// -1 if the slot is empty
+	};
+
+	void Grow();
+
+	std::vector<Slot>				mSlots;		// Power of two size, at most half full
+	std::vector<std::string_view>	mNames;		// Name of every id
+	size_t							mMask;		// mSlots.size() - 1
+};
\ No newline at end of file
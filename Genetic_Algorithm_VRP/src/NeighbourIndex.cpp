@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <numeric>
+
+#include "NeighbourIndex.h"
+
+NeighbourIndex::NeighbourIndex()
+	: mK(0)
+	, mDirection(Direction::Outgoing)
+	, mOffsets(1, 0U)
+{
+}
+
+void NeighbourIndex::Build(const DistanceOracle& distances, int k, Direction direction)
+{
+	const int numCities = distances.Size();
+	const int rowSize = std::max(0, std::min(k, numCities - 1));
+	mK = k;
+	mDirection = direction;
+	mOffsets.resize(static_cast<size_t>(numCities) + 1);
+	for (int i = 0; i <= numCities; i++)
+	{
+		mOffsets[i] = static_cast<uint32_t>(i) * static_cast<uint32_t>(rowSize);
+	}
+	mIds.resize(static_cast<size_t>(numCities) * rowSize);
+	if (rowSize == 0)
+	{
+		return;
+	}
+
+	// Coordinate metrics are symmetric, only a matrix needs the second direction
+	const bool both = direction == Direction::Both && distances.IsMatrix();
+
+#pragma omp parallel
+	{
+		// Distance in the upper and id in the lower half of a key, so the keys sort by distance and then by id.
+		// A missing road (-1) becomes the largest distance
+		std::vector<uint64_t> keys(rowSize);
+		std::vector<int> from(numCities);
+		std::vector<int> to(numCities);
+		std::vector<int> row(numCities);
+		std::vector<int> back(numCities);
+		std::iota(to.begin(), to.end(), 0);
+
+#pragma omp for schedule(dynamic, 16)
+		for (int i = 0; i < numCities; i++)
+		{
+			std::fill(from.begin(), from.end(), i);
+			distances.Batch(from.data(), to.data(), numCities, row.data());
+			if (both)
+			{
+				distances.Batch(to.data(), from.data(), numCities, back.data());
+			}
+
+			// Max-heap of the rowSize best keys, most cities are rejected by one comparison with the worst of them
+			int count = 0;
+			for (int j = 0; j < numCities; j++)
+			{
+				if (j == i)
+				{
+					continue;
+				}
+				uint32_t distance = static_cast<uint32_t>(row[j]);
+				if (both)
+				{
+					distance = std::min(distance, static_cast<uint32_t>(back[j]));
+				}
+				uint64_t key = (static_cast<uint64_t>(distance) << 32) | static_cast<uint32_t>(j);
+				if (count < rowSize)
+				{
+					keys[count++] = key;
+					std::push_heap(keys.begin(), keys.begin() + count);
+				}
+				else if (key < keys[0])
+				{
+					std::pop_heap(keys.begin(), keys.begin() + count);
+					keys[count - 1] = key;
+					std::push_heap(keys.begin(), keys.begin() + count);
+				}
+			}
+			std::sort_heap(keys.begin(), keys.begin() + count);
+
+			uint32_t* ids = mIds.data() + mOffsets[i];
+			for (int n = 0; n < rowSize; n++)
+			{
+				ids[n] = static_cast<uint32_t>(keys[n]);
+			}
+		}
+	}
+}
+
+bool NeighbourIndex::Assign(int k, Direction direction, std::vector<uint32_t> offsets, std::vector<uint32_t> ids)
+{
+	if (offsets.empty() || offsets.front() != 0U || offsets.back() != ids.size() || !std::is_sorted(offsets.begin(), offsets.end()))
+	{
+		return false;
+	}
+	const uint32_t numCities = static_cast<uint32_t>(offsets.size() - 1);
+	if (std::any_of(ids.begin(), ids.end(), [numCities](uint32_t id) { return id >= numCities; }))
+	{
+		return false;
+	}
+	mK = k;
+	mDirection = direction;
+	mOffsets.swap(offsets);
+	mIds.swap(ids);
+	return true;
+}
+
+bool NeighbourIndex::ParseDirection(const std::string& name, Direction& direction)
+{
+	if (name == "outgoing")
+	{
+		direction = Direction::Outgoing;
+		return true;
+	}
+	if (name == "both")
+	{
+		direction = Direction::Both;
+		return true;
+	}
+	return false;
+}
\ No newline at end of file
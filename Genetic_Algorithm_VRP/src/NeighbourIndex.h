@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DistanceOracle.h"
+
+// k nearest neighbours of every city in CSR layout: the neighbours of city i are Ids()[Offsets()[i]] up to
+// Ids()[Offsets()[i + 1]], nearest first and ties by id. Built once per input, read-only afterwards and shared
+// (std::shared_ptr<const NeighbourIndex>) between all solver instances like the distances
+class NeighbourIndex
+{
+public:
+	// Distance that ranks the neighbours, only differs for asymmetric matrices
+	enum class Direction
+	{
+		Outgoing,	// From the city to the neighbour
+		Both		// Shorter of both directions
+	};
+
+	NeighbourIndex();
+
+	// Rows are built in parallel, a row has min(k, number of cities - 1) entries
+	void Build(const DistanceOracle& distances, int k, Direction direction);
+
+	// Takes over a serialized index (see DistanceCache), returns false if the arrays don't fit together
+	bool Assign(int k, Direction direction, std::vector<uint32_t> offsets, std::vector<uint32_t> ids);
+
+	const uint32_t* Begin(int city) const { return mIds.data() + mOffsets[city]; }
+	const uint32_t* End(int city) const { return mIds.data() + mOffsets[city + 1]; }
+	int Count(int city) const { return static_cast<int>(mOffsets[city + 1] - mOffsets[city]); }
+
+	int Size() const { return static_cast<int>(mOffsets.size()) - 1; }
+	int K() const { return mK; }
+	Direction GetDirection() const { return mDirection; }
+	const std::vector<uint32_t>& Offsets() const { return mOffsets; }
+	const std::vector<uint32_t>& Ids() const { return mIds; }
+
+	static bool ParseDirection(const std::string& name, Direction& direction);
+
+private:
+	int						mK;			// Requested neighbours per city
+	Direction				mDirection;
+	std::vector<uint32_t>	mOffsets;	// Start of every row in mIds, one more entry than cities
+	std::vector<uint32_t>	mIds;		// Neighbours of all cities, row after row
+};
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "PathFinder.h"
+#include "DistanceMatrix.h"
 
 #include<set>
 
@@ -6,7 +7,7 @@ std::vector<int> PathFinder::ShortestPath(int start)
 {
     // Assume that the distance from source_node to other nodes is infinite
     // in the beginning, i.e initialize the distance vector to a max value
-    const int INF = 9999999;
+    const int INF = sInfinity;
     std::vector<int> dist(Graph.size(), INF);
     std::set<PII> set_length_node;
 
@@ -45,4 +46,116 @@ std::vector<int> PathFinder::ShortestPath(int start)
     }
 
     return dist;
+}
+
+void PathFinder::ShortestPathHeap(int start, Workspace& workspace, int* dist) const
+{
+    const int numNodes = static_cast<int>(Graph.size());
+    std::vector<int>& heap = workspace.Heap;
+    std::vector<int>& position = workspace.Position;
+    if (static_cast<int>(position.size()) != numNodes)
+    {
+        heap.assign(numNodes, 0);
+        position.assign(numNodes, -1);
+    }
+
+    for (int i = 0; i < numNodes; i++)
+    {
+        dist[i] = sInfinity;
+    }
+
+    // Moves the node at index up until its parent is closer
+    auto siftUp = [&](int index)
+    {
+        int node = heap[index];
+        while (index > 0)
+        {
+            int parent = (index - 1) / 2;
+            if (dist[heap[parent]] <= dist[node])
+            {
+                break;
+            }
+            heap[index] = heap[parent];
+            position[heap[index]] = index;
+            index = parent;
+        }
+        heap[index] = node;
+        position[node] = index;
+    };
+
+    int size = 0;
+    dist[start] = 0;
+    heap[size++] = start;
+    position[start] = 0;
+
+    while (size > 0)
+    {
+        // Pop closest node, move last node to the root and sift it down
+        int sourceNode = heap[0];
+        position[sourceNode] = -1;
+        size--;
+        if (size > 0)
+        {
+            int node = heap[size];
+            int index = 0;
+            while (true)
+            {
+                int child = 2 * index + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+                if (child + 1 < size && dist[heap[child + 1]] < dist[heap[child]])
+                {
+                    child++;
+                }
+                if (dist[heap[child]] >= dist[node])
+                {
+                    break;
+                }
+                heap[index] = heap[child];
+                position[heap[index]] = index;
+                index = child;
+            }
+            heap[index] = node;
+            position[node] = index;
+        }
+
+        for (const auto& it : Graph[sourceNode])
+        {
+            int adjNode = it.first;
+            int length = it.second + dist[sourceNode];
+
+            // Edge relaxation, insert unseen nodes and decrease the key of queued ones
+            if (dist[adjNode] > length)
+            {
+                bool queued = dist[adjNode] != sInfinity;
+                dist[adjNode] = length;
+                if (!queued)
+                {
+                    heap[size] = adjNode;
+                    position[adjNode] = size;
+                    size++;
+                }
+                siftUp(position[adjNode]);
+            }
+        }
+    }
+}
+
+void PathFinder::AllShortestPaths(DistanceMatrix& distances) const
+{
+    const int numNodes = static_cast<int>(Graph.size());
+
+#pragma omp parallel
+    {
+        // One workspace per thread, reused for all of its sources
+        Workspace workspace;
+
+#pragma omp for schedule(dynamic, 16)
+        for (int i = 0; i < numNodes; i++)
+        {
+            ShortestPathHeap(i, workspace, distances[i]);
+        }
+    }
 }
\ No newline at end of file
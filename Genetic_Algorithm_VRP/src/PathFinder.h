@@ -1,6 +1,9 @@
+#pragma once
 #include<iostream>
 #include<vector>
 
+class DistanceMatrix;
+
 // Code from https://algotree.org/algorithms/single_source_shortest_path/dijkstras_shortest_path_c++/
 
 class PathFinder
@@ -10,8 +13,24 @@ public:
     using VPII = std::vector<PII>;
     using VVPII = std::vector<VPII>;
 
+    // Distance of nodes that can't be reached
+    static const int sInfinity = 9999999;
+
+    // Reusable buffers of one thread for ShortestPathHeap
+    struct Workspace
+    {
+        std::vector<int> Heap;      // Nodes ordered as binary min-heap by distance
+        std::vector<int> Position;  // Index of every node in Heap, -1 if not in the heap
+    };
+
     VVPII Graph;
 
+    // Reference implementation using a std::set as priority queue
     std::vector<int> ShortestPath(int start);
-};
 
+    // Same result as ShortestPath, uses an indexed binary heap with decrease-key and writes Graph.size() distances to dist
+    void ShortestPathHeap(int start, Workspace& workspace, int* dist) const;
+
+    // Shortest paths from every node, sources are distributed over all OpenMP threads
+    void AllShortestPaths(DistanceMatrix& distances) const;
+};
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <utility>
+#include <algorithm>
+#include <new>
+
+#include "Population.h"
+#include "Util.h"
+
+Population::Population()
+	: mData(nullptr)
+	, mRows(nullptr)
+	, mFitness(nullptr)
+	, mDirty(nullptr)
+	, mDecoded(nullptr)
+	, mSize(0)
+	, mRouteSize(0)
+	, mCacheSize(0)
+	, mStride(0)
+{
+}
+
+Population::~Population()
+{
+	Release();
+}
+
+void Population::Resize(int size, int routeSize, int cacheSize)
+{
+	if (size == mSize && routeSize == mRouteSize && cacheSize == mCacheSize && mData != nullptr)
+	{
+		return;
+	}
+	Release();
+
+	mSize = size;
+	mRouteSize = routeSize;
+	mCacheSize = cacheSize;
+	mStride = static_cast<int>(Util::PadToCacheLine<int>(routeSize + cacheSize));
+
+	mData = static_cast<int*>(Util::AlignedAlloc(Util::sCacheLineSize, sizeof(int) * mStride * mSize));
+	if (mData == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	mRows = new int* [mSize];
+	mFitness = new int[mSize];
+	mDirty = new bool[mSize];
+	mDecoded = new bool[mSize];
+	for (int i = 0; i < mSize; i++)
+	{
+		mRows[i] = mData + static_cast<size_t>(i) * mStride;
+		mFitness[i] = 0;
+		mDirty[i] = true;
+		mDecoded[i] = false;
+	}
+}
+
+void Population::Swap(Population& other)
+{
+	std::swap(mData, other.mData);
+	std::swap(mRows, other.mRows);
+	std::swap(mFitness, other.mFitness);
+	std::swap(mDirty, other.mDirty);
+	std::swap(mDecoded, other.mDecoded);
+	std::swap(mSize, other.mSize);
+	std::swap(mRouteSize, other.mRouteSize);
+	std::swap(mCacheSize, other.mCacheSize);
+	std::swap(mStride, other.mStride);
+}
+
+void Population::SwapRows(int first, int second)
+{
+	std::swap(mRows[first], mRows[second]);
+	std::swap(mFitness[first], mFitness[second]);
+	std::swap(mDirty[first], mDirty[second]);
+	std::swap(mDecoded[first], mDecoded[second]);
+}
+
+void Population::CopyRow(const Population& from, int fromIndex, int toIndex)
+{
+	std::copy(from.mRows[fromIndex], from.mRows[fromIndex] + mRouteSize + mCacheSize, mRows[toIndex]);
+	mFitness[toIndex] = from.mFitness[fromIndex];
+	mDirty[toIndex] = from.mDirty[fromIndex];
+	mDecoded[toIndex] = from.mDecoded[fromIndex];
+}
+
+void Population::Release()
+{
+	Util::AlignedFree(mData);
+	delete[] mRows;
+	delete[] mFitness;
+	delete[] mDirty;
+	delete[] mDecoded;
+	mData = nullptr;
+	mRows = nullptr;
+	mFitness = nullptr;
+	mDirty = nullptr;
+	mDecoded = nullptr;
+	mSize = 0;
+	mRouteSize = 0;
+	mCacheSize = 0;
+	mStride = 0;
+}
\ No newline at end of file
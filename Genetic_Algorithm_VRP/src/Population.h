@@ -0,0 +1,60 @@
+#pragma once
+
+// Stores all individuals of one generation in a single cache line aligned buffer.
+// Every individual is a row of mRouteSize ints followed by mCacheSize ints of cached evaluation data,
+// rows are padded to whole cache lines.
+// The row views can be reordered (e.g. by sort) without moving the chromosomes.
+class Population
+{
+public:
+	Population();
+	~Population();
+
+	Population(const Population&) = delete;
+	Population& operator=(const Population&) = delete;
+
+	// Allocates the arena, does nothing if the dimensions did not change
+	void Resize(int size, int routeSize, int cacheSize = 0);
+	void Swap(Population& other);
+
+	int* operator[](int index) { return mRows[index]; }
+	const int* operator[](int index) const { return mRows[index]; }
+
+	// Evaluation cache stored behind the chromosome, moves together with the row
+	int* Cache(int index) { return mRows[index] + mRouteSize; }
+	const int* Cache(int index) const { return mRows[index] + mRouteSize; }
+
+	int* Fitness() { return mFitness; }
+	const int* Fitness() const { return mFitness; }
+
+	// Dirty individuals were changed since their fitness (and cache) was calculated, a change also clears the decoded flag
+	bool IsDirty(int index) const { return mDirty[index]; }
+	void SetDirty(int index, bool dirty) { mDirty[index] = dirty; mDecoded[index] = mDecoded[index] && !dirty; }
+
+	// A giant tour whose routes were already cut (e.g. improved by the local search) is evaluated without Split
+	bool IsDecoded(int index) const { return mDecoded[index]; }
+	void SetDecoded(int index, bool decoded) { mDecoded[index] = decoded; }
+
+	// Swaps the views (fitness and flags) of two individuals, the chromosomes stay in place
+	void SwapRows(int first, int second);
+
+	// Copies chromosome, cache, fitness and flags of an individual of another population
+	void CopyRow(const Population& from, int fromIndex, int toIndex);
+
+	int Size() const { return mSize; }
+	int RouteSize() const { return mRouteSize; }
+	int Stride() const { return mStride; }
+
+private:
+	void Release();
+
+	int*	mData;			// Flat, aligned storage of all chromosomes
+	int**	mRows;			// Row views into mData
+	int*	mFitness;		// Fitness of every row view
+	bool*	mDirty;			// Dirty flag of every row view
+	bool*	mDecoded;		// Decoded flag of every row view
+	int		mSize;			// Number of individuals
+	int		mRouteSize;		// Length of one chromosome
+	int		mCacheSize;		// Length of the cache behind every chromosome
+	int		mStride;		// Distance between two rows in ints
+};
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "Profiler.h"
+
+std::atomic<Profiler::ThreadBuffer*> Profiler::sBuffers(nullptr);
+std::atomic<int> Profiler::sNumSites(0);
+std::atomic<int> Profiler::sNumThreads(0);
+std::atomic<size_t> Profiler::sMaxEvents(size_t(1) << 20);
+const char* Profiler::sSiteNames[Profiler::sMaxSites];
+thread_local Profiler::ThreadBuffer* Profiler::sThreadBuffer = nullptr;
+
+static const std::chrono::steady_clock::time_point sEpoch = std::chrono::steady_clock::now();
+
+Profiler::Site::Site(const char* name)
+	: Name(name)
+	, Id(sNumSites.fetch_add(1, std::memory_order_relaxed))
+{
+	if (Id < sMaxSites)
+	{
+		sSiteNames[Id] = name;
+	}
+}
+
+Profiler::ScopedTimer::ScopedTimer(const Site& site)
+	: mSiteId(site.Id)
+	, mStart(0U)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	if (buffer->Depth < sMaxDepth)
+	{
+		buffer->ChildTime[buffer->Depth] = 0U;
+	}
+	buffer->Depth++;
+	mStart = Now();
+}
+
+Profiler::ScopedTimer::~ScopedTimer()
+{
+	uint64_t end = Now();
+	Record(sThreadBuffer, mSiteId, mStart, end);
+}
+
+bool Profiler::IsEnabled()
+{
+#ifdef ENABLE_PROFILER
+	return true;
+#else
+	return false;
+#endif
+}
+
+void Profiler::SetMaxEvents(size_t maxEvents)
+{
+	sMaxEvents.store(maxEvents, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sEpoch).count());
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (sThreadBuffer == nullptr)
+	{
+		// First span of this thread, push a new buffer to the lock-free list
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->ThreadId = sNumThreads.fetch_add(1, std::memory_order_relaxed);
+		buffer->Depth = 0;
+		buffer->DroppedEvents = 0U;
+		buffer->Next = sBuffers.load(std::memory_order_relaxed);
+		while (!sBuffers.compare_exchange_weak(buffer->Next, buffer, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+		sThreadBuffer = buffer;
+	}
+	return sThreadBuffer;
+}
+
+void Profiler::Record(ThreadBuffer* buffer, int siteId, uint64_t start, uint64_t end)
+{
+	buffer->Depth--;
+	int depth = buffer->Depth;
+	uint64_t duration = end - start;
+
+	// Time of nested spans is subtracted for the self time, this span is nested time of its parent
+	uint64_t childTime = depth < sMaxDepth ? buffer->ChildTime[depth] : 0U;
+	if (depth > 0 && depth - 1 < sMaxDepth)
+	{
+		buffer->ChildTime[depth - 1] += duration;
+	}
+
+	if (siteId >= static_cast<int>(buffer->Statistics.size()))
+	{
+		buffer->Statistics.resize(siteId + 1);
+	}
+	Statistic& statistic = buffer->Statistics[siteId];
+	statistic.Calls++;
+	statistic.Total += duration;
+	statistic.Self += duration - std::min(childTime, duration);
+	statistic.Max = std::max(statistic.Max, duration);
+
+	if (buffer->Events.size() < sMaxEvents.load(std::memory_order_relaxed))
+	{
+		buffer->Events.push_back(Event{ siteId, depth, start, duration });
+	}
+	else
+	{
+		buffer->DroppedEvents++;
+	}
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	// Trace event format, complete events ("ph":"X") with timestamps in microseconds
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	file << std::fixed << std::setprecision(3);
+	for (ThreadBuffer* buffer = sBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->Next)
+	{
+		file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->ThreadId
+			<< ",\"args\":{\"name\":\"Thread " << buffer->ThreadId << "\"}}";
+		first = false;
+		for (const Event& event : buffer->Events)
+		{
+			const char* name = event.SiteId < sMaxSites ? sSiteNames[event.SiteId] : "unknown";
+			file << ",\n{\"name\":\"" << name << "\",\"cat\":\"vrp\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->ThreadId
+				<< ",\"ts\":" << event.Start / 1000.0 << ",\"dur\":" << event.Duration / 1000.0 << "}";
+		}
+	}
+	file << "\n]}\n";
+	return true;
+}
+
+void Profiler::PrintSummary()
+{
+	// Aggregate all threads per name
+	std::map<std::string, Statistic> phases;
+	uint64_t dropped = 0U;
+	int numThreads = 0;
+	for (ThreadBuffer* buffer = sBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->Next)
+	{
+		for (size_t i = 0; i < buffer->Statistics.size(); i++)
+		{
+			const Statistic& statistic = buffer->Statistics[i];
+			if (statistic.Calls == 0U)
+			{
+				continue;
+			}
+			Statistic& phase = phases[i < sMaxSites ? sSiteNames[i] : "unknown"];
+			phase.Calls += statistic.Calls;
+			phase.Total += statistic.Total;
+			phase.Self += statistic.Self;
+			phase.Max = std::max(phase.Max, statistic.Max);
+		}
+		dropped += buffer->DroppedEvents;
+		numThreads++;
+	}
+
+	std::vector<std::pair<std::string, Statistic>> sorted(phases.begin(), phases.end());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, Statistic>& a, const std::pair<std::string, Statistic>& b) { return a.second.Self > b.second.Self; });
+
+	std::cout << "Profile (" << numThreads << " threads, times summed over all threads):" << std::endl;
+	std::cout << std::left << std::setw(24) << "Phase" << std::right << std::setw(12) << "Calls" << std::setw(14) << "Total [ms]"
+		<< std::setw(14) << "Self [ms]" << std::setw(14) << "Avg [us]" << std::setw(14) << "Max [us]" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const auto& phase : sorted)
+	{
+		const Statistic& statistic = phase.second;
+		std::cout << std::left << std::setw(24) << phase.first << std::right << std::setw(12) << statistic.Calls
+			<< std::setw(14) << statistic.Total / 1e6 << std::setw(14) << statistic.Self / 1e6
+			<< std::setw(14) << statistic.Total / 1e3 / statistic.Calls << std::setw(14) << statistic.Max / 1e3 << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+	if (dropped > 0U)
+	{
+		std::cout << dropped << " trace events dropped (limit per thread reached), the table is complete" << std::endl;
+	}
+}
+
+void Profiler::Clear()
+{
+	// Buffers stay registered, their threads may record again later
+	for (ThreadBuffer* buffer = sBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->Next)
+	{
+		buffer->Events.clear();
+		buffer->Statistics.clear();
+		buffer->DroppedEvents = 0U;
+	}
+}
\ No newline at end of file
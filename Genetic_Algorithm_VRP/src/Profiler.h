@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hierarchical scoped-timer profiler.
+// Every thread records into its own buffer without locking; the buffers are only read after all threads joined.
+// Use PROFILE_SCOPE("Name") at the start of a scope. Without ENABLE_PROFILER (make PROFILE=1) the macro expands to nothing.
+class Profiler
+{
+public:
+	// One PROFILE_SCOPE location, the id indexes the per thread statistics
+	struct Site
+	{
+		explicit Site(const char* name);
+
+		const char*	Name;
+		int			Id;
+	};
+
+	struct Event
+	{
+		int			SiteId;
+		int			Depth;		// Nesting level, 0 for outermost spans
+		uint64_t	Start;		// Nanoseconds since the profiler epoch
+		uint64_t	Duration;	// Nanoseconds
+	};
+
+	struct Statistic
+	{
+		uint64_t	Calls = 0U;
+		uint64_t	Total = 0U;		// Nanoseconds including nested spans
+		uint64_t	Self = 0U;		// Nanoseconds without nested spans
+		uint64_t	Max = 0U;
+	};
+
+	// Timer of one span, records on destruction
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(const Site& site);
+		~ScopedTimer();
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		int			mSiteId;
+		uint64_t	mStart;
+	};
+
+	static bool IsEnabled();
+
+	// Maximum trace events kept per thread, statistics are always complete
+	static void SetMaxEvents(size_t maxEvents);
+
+	// Must only be called while no thread records
+	static bool WriteChromeTrace(const std::string& path);
+	static void PrintSummary();
+	static void Clear();
+
+	static uint64_t Now();
+
+private:
+	static const int sMaxDepth = 64;
+
+	struct ThreadBuffer
+	{
+		int							ThreadId;
+		int							Depth;
+		uint64_t					ChildTime[sMaxDepth];	// Time of nested spans per open level
+		std::vector<Event>			Events;
+		std::vector<Statistic>		Statistics;				// Indexed by site id
+		uint64_t					DroppedEvents;
+		ThreadBuffer*				Next;
+	};
+
+	static const int sMaxSites = 256;
+
+	static ThreadBuffer* GetThreadBuffer();
+	static void Record(ThreadBuffer* buffer, int siteId, uint64_t start, uint64_t end);
+
+	static thread_local ThreadBuffer*	sThreadBuffer;	// Buffer of the calling thread
+	static std::atomic<ThreadBuffer*>	sBuffers;	// Lock-free list of all thread buffers
+	static std::atomic<int>				sNumSites;
+	static std::atomic<int>				sNumThreads;
+	static std::atomic<size_t>			sMaxEvents;
+	static const char*					sSiteNames[sMaxSites];
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_SCOPE(name) \
+	static const Profiler::Site PROFILE_CONCAT(profileSite, __LINE__)(name); \
+	Profiler::ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profileSite, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** pseudo random number generator (http://prng.di.unimi.it/)
+// Satisfies UniformRandomBitGenerator, so it can be used with all std distributions.
+// Jump() advances the state by 2^128 draws, which is used to split one seed into independent streams.
+class Xoshiro256
+{
+public:
+	using result_type = uint64_t;
+
+	explicit Xoshiro256(uint64_t seed = 0U)
+	{
+		Seed(seed);
+	}
+
+	// Expands the seed to the full state with SplitMix64, as recommended by the authors
+	void Seed(uint64_t seed)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			mState[i] = z ^ (z >> 31);
+		}
+	}
+
+	// Seeds and jumps ahead stream times, streams of the same seed never overlap
+	void Seed(uint64_t seed, int stream)
+	{
+		Seed(seed);
+		for (int i = 0; i < stream; i++)
+		{
+			Jump();
+		}
+	}
+
+	static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		const uint64_t result = Rotl(mState[1] * 5, 7) * 9;
+		const uint64_t t = mState[1] << 17;
+
+		mState[2] ^= mState[0];
+		mState[3] ^= mState[1];
+		mState[1] ^= mState[2];
+		mState[0] ^= mState[3];
+
+		mState[2] ^= t;
+		mState[3] = Rotl(mState[3], 45);
+
+		return result;
+	}
+
+	void Jump()
+	{
+		static const uint64_t sJump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+		uint64_t s[4] = { 0U, 0U, 0U, 0U };
+		for (uint64_t jump : sJump)
+		{
+			for (int b = 0; b < 64; b++)
+			{
+				if (jump & (uint64_t(1) << b))
+				{
+					for (int i = 0; i < 4; i++)
+					{
+						s[i] ^= mState[i];
+					}
+				}
+				(*this)();
+			}
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			mState[i] = s[i];
+		}
+	}
+
+private:
+	static uint64_t Rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t mState[4];
+};
\ No newline at end of file
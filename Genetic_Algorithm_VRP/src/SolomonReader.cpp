@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+
+#include "SolomonReader.h"
+
+namespace
+{
+	const int sValuesPerCustomer = 7;	// Id, x, y, demand, ready time, due date, service time
+
+	int NearestInt(double value)
+	{
+		return static_cast<int>(value + 0.5);
+	}
+}
+
+bool SolomonReader::CanRead(std::string_view head) const
+{
+	return head.find("VEHICLE") != std::string_view::npos && head.find("CUSTOMER") != std::string_view::npos;
+}
+
+bool SolomonReader::Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const
+{
+	TokenStream tokens(data, data + size);
+	instance.Capacity = 0;
+	instance.Depot = 0;
+
+	// Skip the name and the column titles of the vehicle section
+	while (!tokens.AtEnd() && tokens.Next() != "CAPACITY")
+	{
+	}
+	int numVehicles;
+	if (!tokens.Number(numVehicles) || !tokens.Number(instance.Capacity))
+	{
+		std::cout << "Solomon: invalid VEHICLE section" << std::endl;
+		return false;
+	}
+
+	// Column titles of the customer section end with the line before the first customer
+	while (!tokens.AtEnd() && tokens.Next() != "CUSTOMER")
+	{
+	}
+	while (!tokens.AtEnd() && tokens.TokensInLine() != sValuesPerCustomer)
+	{
+		tokens.RestOfLine();
+	}
+
+	instance.Cities.clear();
+	instance.TimeWindows.clear();
+	instance.X.clear();
+	instance.Y.clear();
+	while (!tokens.AtEnd())
+	{
+		double values[sValuesPerCustomer];
+		for (double& value : values)
+		{
+			if (!tokens.Number(value))
+			{
+				std::cout << "Solomon: invalid customer " << instance.Cities.size() << std::endl;
+				return false;
+			}
+		}
+		if (NearestInt(values[0]) != static_cast<int>(instance.Cities.size()))
+		{
+			std::cout << "Solomon: customers have to be numbered 0, 1, 2, ..." << std::endl;
+			return false;
+		}
+
+		// Cities are named by their customer number
+		instance.Cities.push_back(City{ std::to_string(instance.Cities.size()), static_cast<float>(values[1]), static_cast<float>(values[2]), NearestInt(values[3]) });
+		instance.TimeWindows.push_back(TimeWindow{ NearestInt(values[4]), NearestInt(values[5]), NearestInt(values[6]) });
+		instance.X.push_back(values[1]);
+		instance.Y.push_back(values[2]);
+	}
+	if (instance.Cities.empty())
+	{
+		std::cout << "Solomon: no customers" << std::endl;
+		return false;
+	}
+
+	instance.Metric = DistanceOracle::Metric::Euclidean;
+	instance.HasMissingRoutes = false;
+	instance.Distances = nullptr;
+	if (buildMatrix)
+	{
+		int numCities = static_cast<int>(instance.Cities.size());
+		std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(numCities);
+		DistanceOracle(instance.Metric, instance.X, instance.Y).FillMatrix(*distancePtr);
+		instance.Distances = distancePtr;
+	}
+	return true;
+}
\ No newline at end of file
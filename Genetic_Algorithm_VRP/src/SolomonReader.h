@@ -0,0 +1,14 @@
+#pragma once
+
+#include "InstanceReader.h"
+
+// Solomon and Gehring & Homberger VRPTW instances: a name line, VEHICLE (number, capacity) and
+// CUSTOMER (id, x, y, demand, ready time, due date, service time) sections. Customer 0 is the depot.
+// Distances and travel times are EUC_2D (rounded to the nearest integer) so they fit the integer fitness.
+class SolomonReader : public InstanceReader
+{
+public:
+	const char* Name() const override { return "Solomon VRPTW"; }
+	bool CanRead(std::string_view head) const override;
+	bool Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const override;
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <limits>
+
+#include "Split.h"
+
+const int64_t Split::sInfinity = std::numeric_limits<int64_t>::max() / 4;
+
+int64_t Split::Decode(const DistanceOracle& distances, int depot, const int* tour, int size, int vehicles,
+	const int* demands, int capacity, int penalty, int* routeEnds)
+{
+	// Customer j (1-based) is tour[j - 1]. Edges inside a route are measured from the later city back to the earlier
+	// one like in EvaluateFitness, which matters for asymmetric matrices
+	const int stride = size + 1;
+	mDistance.assign(stride, 0);
+	mLoad.assign(stride, 0);
+	for (int j = 1; j <= size; j++)
+	{
+		mDistance[j] = j > 1 ? mDistance[j - 1] + distances(tour[j - 1], tour[j - 2]) : 0;
+		mLoad[j] = mLoad[j - 1] + (demands != nullptr ? demands[tour[j - 1]] : 0);
+	}
+	const bool penalized = demands != nullptr && capacity > 0;
+
+	mCost.assign(static_cast<size_t>(vehicles + 1) * stride, sInfinity);
+	mPredecessor.assign(static_cast<size_t>(vehicles + 1) * stride, -1);
+	mQueue.resize(stride);
+	mCost[0] = 0;
+
+	for (int k = 1; k <= vehicles; k++)
+	{
+		const int64_t* previous = mCost.data() + static_cast<size_t>(k - 1) * stride;
+		int64_t* cost = mCost.data() + static_cast<size_t>(k) * stride;
+		int* predecessor = mPredecessor.data() + static_cast<size_t>(k) * stride;
+
+		// EvaluateFitness measures the edge between the depot and the first customer of the first route backwards
+		auto firstEdge = [&](int i) { return k == 1 ? distances(tour[i], depot) : distances(depot, tour[i]); };
+
+		// The fitness does not count the return of the last route and the edge into the last customer of the chromosome
+		// (unless the customer follows a blank), the last route only matters for all customers and is found in O(n)
+		if (k == vehicles)
+		{
+			for (int i = k - 1; i < size; i++)
+			{
+				if (previous[i] >= sInfinity)
+				{
+					continue;
+				}
+				int64_t route = size - i >= 2 ? firstEdge(i) + mDistance[size - 1] - mDistance[i + 1] : (k > 1 ? firstEdge(i) : 0);
+				if (penalized && mLoad[size] - mLoad[i] > capacity)
+				{
+					route += penalty * (mLoad[size] - mLoad[i] - capacity);
+				}
+				if (previous[i] + route < cost[size])
+				{
+					cost[size] = previous[i] + route;
+					predecessor[size] = i;
+				}
+			}
+			break;
+		}
+
+		// Cost of a route from customer i + 1 to j without penalty: start(i) + mDistance[j] + back to the depot from j
+		auto start = [&](int i) { return previous[i] + firstEdge(i) - mDistance[i + 1]; };
+
+		// Route starts that are not penalized (load up to the capacity) are in the deque, ordered by increasing start cost.
+		// Earlier starts are penalized, their best one is kept as running minimum with the load taken out
+		int head = 0;
+		int tail = 0;
+		int boundary = k - 1;
+		int64_t bestPenalized = sInfinity;
+		int bestPenalizedStart = -1;
+
+		// The remaining vehicles - k routes need at least one customer each
+		for (int j = k; j <= size - (vehicles - k); j++)
+		{
+			int i = j - 1;
+			if (previous[i] < sInfinity)
+			{
+				while (tail > head && start(mQueue[tail - 1]) >= start(i))
+				{
+					tail--;
+				}
+				mQueue[tail++] = i;
+			}
+
+			if (penalized)
+			{
+				while (boundary < j && mLoad[j] - mLoad[boundary] > capacity)
+				{
+					if (previous[boundary] < sInfinity && start(boundary) - penalty * mLoad[boundary] < bestPenalized)
+					{
+						bestPenalized = start(boundary) - penalty * mLoad[boundary];
+						bestPenalizedStart = boundary;
+					}
+					boundary++;
+				}
+				while (tail > head && mQueue[head] < boundary)
+				{
+					head++;
+				}
+			}
+
+			int64_t end = mDistance[j] + distances(tour[j - 1], depot);
+			if (tail > head)
+			{
+				cost[j] = start(mQueue[head]) + end;
+				predecessor[j] = mQueue[head];
+			}
+			if (bestPenalizedStart >= 0 && bestPenalized + penalty * (mLoad[j] - capacity) + end < cost[j])
+			{
+				cost[j] = bestPenalized + penalty * (mLoad[j] - capacity) + end;
+				predecessor[j] = bestPenalizedStart;
+			}
+		}
+	}
+
+	// Follow the predecessors back from the last customer
+	int j = size;
+	for (int k = vehicles; k >= 1; k--)
+	{
+		routeEnds[k - 1] = j;
+		j = mPredecessor[static_cast<size_t>(k) * stride + j];
+	}
+	return mCost[static_cast<size_t>(vehicles) * stride + size];
+}
\ No newline at end of file
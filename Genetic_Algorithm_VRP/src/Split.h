@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DistanceOracle.h"
+
+// Prins' Split: optimal partition of a giant tour (all customers in visiting order) into a fixed number of
+// non-empty routes. Minimizes the route length of EvaluateFitness plus a linear penalty for the load above the
+// capacity: the edge from the depot to the first customer is measured backwards, the last route does not return
+// to the depot and the edge into the last customer only counts if it starts at the depot. The balance term of the
+// fitness (difference to the average route length) is not a sum over routes and is ignored. Every layer (routes used so far) is computed in O(n) with a monotone deque
+// (Vidal, "Split algorithm in O(n) for the capacitated vehicle routing problem", 2016), the last one in O(n) with a scan,
+// O(n * vehicles) in total.
+// The buffers are reused, one instance per thread.
+class Split
+{
+public:
+	// Writes the end (index after the last customer in tour) of every route into routeEnds and returns the cost.
+	// demands can be nullptr, capacity 0 disables the penalty. vehicles has to be between 1 and size
+	int64_t Decode(const DistanceOracle& distances, int depot, const int* tour, int size, int vehicles,
+		const int* demands, int capacity, int penalty, int* routeEnds);
+
+private:
+	static const int64_t sInfinity;
+
+	std::vector<int64_t>	mDistance;		// Distance along the tour from the first customer to customer j
+	std::vector<int64_t>	mLoad;			// Demand of the first j customers
+	std::vector<int64_t>	mCost;			// Cost of the first j customers in k routes, one row per k
+	std::vector<int>		mPredecessor;	// Last customer of the previous route of the best solution, one row per k
+	std::vector<int>		mQueue;			// Monotone deque of route starts
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+
+// Service time window of a customer, times are in distance units (travel time = distance)
+struct TimeWindow
+{
+	int Ready;		// Earliest start of the service
+	int Due;		// Latest start of the service
+	int Service;	// Duration of the service
+};
+
+// Summary of a sequence of visits that can be concatenated in O(1) (Vidal et al., "A hybrid genetic algorithm
+// with adaptive diversity management", 2013). A vehicle that arrives after the due time travels back in time,
+// the time warp is the penalized lateness. With the forward (depot to i) and backward (i to depot) segment of
+// every position of a route, removal, insertion, 2-opt* and swaps between two routes are evaluated in O(1)
+struct TimeSegment
+{
+	static const int sInts = 4;	// Size when stored in an int array
+
+	int Duration;	// Travel, waiting and service time
+	int TimeWarp;	// Total lateness
+	int Earliest;	// Earliest start of the first service
+	int Latest;		// Latest start of the first service without additional time warp
+
+	static TimeSegment Visit(const TimeWindow& window)
+	{
+		return TimeSegment{ window.Service, 0, window.Ready, window.Due };
+	}
+
+	// This sequence followed by next, travel is the time from the last visit of this one to the first of next
+	TimeSegment Then(const TimeSegment& next, int travel) const
+	{
+		int delta = Duration - TimeWarp + travel;
+		int waiting = std::max(next.Earliest - delta - Latest, 0);
+		int warp = std::max(Earliest + delta - next.Latest, 0);
+		return TimeSegment{
+			Duration + next.Duration + travel + waiting,
+			TimeWarp + next.TimeWarp + warp,
+			std::max(next.Earliest - delta, Earliest) - waiting,
+			std::min(next.Latest - delta, Latest) + warp };
+	}
+
+	static TimeSegment Load(const int* data)
+	{
+		return TimeSegment{ data[0], data[1], data[2], data[3] };
+	}
+
+	void Store(int* data) const
+	{
+		data[0] = Duration;
+		data[1] = TimeWarp;
+		data[2] = Earliest;
+		data[3] = Latest;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include <iostream>
+#include <cmath>
+#include <string>
+
+#include "TsplibReader.h"
+
+namespace
+{
+	int NearestInt(double value)
+	{
+		return static_cast<int>(value + 0.5);
+	}
+
+	// Reads count lines of "id value..." into values, ids are 1-based
+	bool ReadNodeSection(TokenStream& tokens, int dimension, int valuesPerNode, std::vector<double>& values, std::string_view section)
+	{
+		values.assign(static_cast<size_t>(dimension) * valuesPerNode, 0.0);
+		for (int i = 0; i < dimension; i++)
+		{
+			int id;
+			if (!tokens.Number(id) || id < 1 || id > dimension)
+			{
+				std::cout << "TSPLIB: invalid node id in " << section << std::endl;
+				return false;
+			}
+			for (int k = 0; k < valuesPerNode; k++)
+			{
+				if (!tokens.Number(values[static_cast<size_t>(id - 1) * valuesPerNode + k]))
+				{
+					std::cout << "TSPLIB: invalid value of node " << id << " in " << section << std::endl;
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+bool TsplibReader::CanRead(std::string_view head) const
+{
+	return head.find("DIMENSION") != std::string_view::npos;
+}
+
+bool TsplibReader::Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const
+{
+	std::string weightType = "EUC_2D";
+	std::string weightFormat = "FULL_MATRIX";
+	int dimension = 0;
+	std::vector<double> coordinates;	// x, y of every node
+	std::vector<double> display;		// Coordinates only used for drawing
+	std::vector<double> weights;		// EDGE_WEIGHT_SECTION in file order
+	std::vector<double> demands;		// Demand of every node
+
+	instance.Capacity = 0;
+	instance.Depot = -1;
+
+	// Specification part (KEYWORD : value) followed by data sections, both may be mixed
+	TokenStream tokens(data, data + size);
+	while (!tokens.AtEnd())
+	{
+		std::string_view keyword = tokens.Keyword();
+		if (keyword == "EOF")
+		{
+			break;
+		}
+		else if (keyword == "DIMENSION")
+		{
+			if (!tokens.Number(dimension) || dimension <= 0)
+			{
+				std::cout << "TSPLIB: invalid DIMENSION" << std::endl;
+				return false;
+			}
+		}
+		else if (keyword == "CAPACITY")
+		{
+			if (!tokens.Number(instance.Capacity))
+			{
+				std::cout << "TSPLIB: invalid CAPACITY" << std::endl;
+				return false;
+			}
+		}
+		else if (keyword == "EDGE_WEIGHT_TYPE")
+		{
+			weightType = tokens.RestOfLine();
+		}
+		else if (keyword == "EDGE_WEIGHT_FORMAT")
+		{
+			weightFormat = tokens.RestOfLine();
+		}
+		else if (keyword == "NODE_COORD_SECTION")
+		{
+			if (!ReadNodeSection(tokens, dimension, 2, coordinates, keyword))
+			{
+				return false;
+			}
+		}
+		else if (keyword == "DISPLAY_DATA_SECTION")
+		{
+			if (!ReadNodeSection(tokens, dimension, 2, display, keyword))
+			{
+				return false;
+			}
+		}
+		else if (keyword == "DEMAND_SECTION")
+		{
+			if (!ReadNodeSection(tokens, dimension, 1, demands, keyword))
+			{
+				return false;
+			}
+		}
+		else if (keyword == "DEPOT_SECTION")
+		{
+			// List of depots terminated by -1, the solver supports one
+			int id;
+			while (tokens.Number(id) && id != -1)
+			{
+				if (id < 1 || id > dimension)
+				{
+					std::cout << "TSPLIB: invalid depot " << id << std::endl;
+					return false;
+				}
+				if (instance.Depot < 0)
+				{
+					instance.Depot = id - 1;
+				}
+				else
+				{
+					std::cout << "TSPLIB: only one depot is supported, ignoring depot " << id << std::endl;
+				}
+			}
+		}
+		else if (keyword == "EDGE_WEIGHT_SECTION")
+		{
+			size_t n = static_cast<size_t>(dimension);
+			size_t count = 0U;
+			if (weightFormat == "FULL_MATRIX")
+			{
+				count = n * n;
+			}
+			else if (weightFormat == "UPPER_ROW" || weightFormat == "LOWER_ROW")
+			{
+				count = n * (n - 1U) / 2U;
+			}
+			else if (weightFormat == "UPPER_DIAG_ROW" || weightFormat == "LOWER_DIAG_ROW")
+			{
+				count = n * (n + 1U) / 2U;
+			}
+			else
+			{
+				std::cout << "TSPLIB: unsupported EDGE_WEIGHT_FORMAT " << weightFormat << std::endl;
+				return false;
+			}
+
+			weights.resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (!tokens.Number(weights[i]))
+				{
+					std::cout << "TSPLIB: EDGE_WEIGHT_SECTION has less than " << count << " weights" << std::endl;
+					return false;
+				}
+			}
+		}
+		else if (keyword.size() > 8U && keyword.substr(keyword.size() - 8U) == "_SECTION")
+		{
+			std::cout << "TSPLIB: unsupported " << keyword << std::endl;
+			return false;
+		}
+		else
+		{
+			// NAME, TYPE, COMMENT, ... are not needed
+			tokens.RestOfLine();
+		}
+	}
+
+	if (dimension <= 0)
+	{
+		std::cout << "TSPLIB: DIMENSION is missing" << std::endl;
+		return false;
+	}
+
+	instance.X.clear();
+	instance.Y.clear();
+	instance.Metric = DistanceOracle::Metric::Matrix;
+	instance.Distances = nullptr;
+	if (weightType == "EXPLICIT")
+	{
+		if (weights.empty())
+		{
+			std::cout << "TSPLIB: EDGE_WEIGHT_SECTION is missing" << std::endl;
+			return false;
+		}
+
+		std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(dimension);
+		DistanceMatrix& distances = *distancePtr;
+
+		// Rows of the upper triangle are the columns of the lower one and vice versa
+		bool upper = weightFormat == "UPPER_ROW" || weightFormat == "UPPER_DIAG_ROW";
+		bool diagonal = weightFormat == "UPPER_DIAG_ROW" || weightFormat == "LOWER_DIAG_ROW";
+		size_t index = 0U;
+		for (int i = 0; i < dimension; i++)
+		{
+			if (weightFormat == "FULL_MATRIX")
+			{
+				for (int j = 0; j < dimension; j++)
+				{
+					distances[i][j] = NearestInt(weights[index++]);
+				}
+				continue;
+			}
+
+			int first = upper ? (diagonal ? i : i + 1) : 0;
+			int last = upper ? dimension : (diagonal ? i + 1 : i);
+			for (int j = first; j < last; j++)
+			{
+				int distance = NearestInt(weights[index++]);
+				distances[i][j] = distance;
+				distances[j][i] = distance;
+			}
+			distances[i][i] = 0;
+		}
+		instance.Distances = distancePtr;
+	}
+	else
+	{
+		if (weightType == "EUC_2D")
+		{
+			instance.Metric = DistanceOracle::Metric::Euclidean;
+		}
+		else if (weightType == "CEIL_2D")
+		{
+			instance.Metric = DistanceOracle::Metric::EuclideanCeil;
+		}
+		else if (weightType == "GEO")
+		{
+			instance.Metric = DistanceOracle::Metric::Geographical;
+		}
+		else if (weightType == "ATT")
+		{
+			instance.Metric = DistanceOracle::Metric::Pseudoeuclidean;
+		}
+		else
+		{
+			std::cout << "TSPLIB: unsupported EDGE_WEIGHT_TYPE " << weightType << std::endl;
+			return false;
+		}
+		if (coordinates.empty())
+		{
+			std::cout << "TSPLIB: NODE_COORD_SECTION is missing" << std::endl;
+			return false;
+		}
+
+		for (int i = 0; i < dimension; i++)
+		{
+			instance.X.push_back(coordinates[2 * i]);
+			instance.Y.push_back(coordinates[2 * i + 1]);
+		}
+		if (buildMatrix)
+		{
+			std::shared_ptr<DistanceMatrix> distancePtr = std::make_shared<DistanceMatrix>(dimension);
+			DistanceOracle(instance.Metric, instance.X, instance.Y).FillMatrix(*distancePtr);
+			instance.Distances = distancePtr;
+		}
+	}
+
+	// Cities are named by their TSPLIB id
+	const std::vector<double>& position = coordinates.empty() ? display : coordinates;
+	instance.Cities.clear();
+	for (int i = 0; i < dimension; i++)
+	{
+		float x = position.empty() ? 0.0f : static_cast<float>(position[2 * i]);
+		float y = position.empty() ? 0.0f : static_cast<float>(position[2 * i + 1]);
+		int demand = demands.empty() ? 0 : NearestInt(demands[i]);
+		instance.Cities.push_back(City{ std::to_string(i + 1), x, y, demand });
+	}
+	instance.HasMissingRoutes = false;
+	return true;
+}
\ No newline at end of file
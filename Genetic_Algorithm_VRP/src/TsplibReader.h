@@ -0,0 +1,15 @@
+#pragma once
+
+#include "InstanceReader.h"
+
+// TSPLIB and CVRPLIB instances: EXPLICIT weights (FULL_MATRIX, UPPER_ROW, LOWER_ROW, UPPER_DIAG_ROW, LOWER_DIAG_ROW),
+// EUC_2D, CEIL_2D, GEO and ATT coordinates, DEMAND_SECTION, DEPOT_SECTION and CAPACITY.
+// Distances follow the TSPLIB definitions, so tour lengths match the published optima.
+// Coordinate based instances can skip the matrix, distances are then computed by DistanceOracle.
+class TsplibReader : public InstanceReader
+{
+public:
+	const char* Name() const override { return "TSPLIB"; }
+	bool CanRead(std::string_view head) const override;
+	bool Read(const char* data, size_t size, bool buildMatrix, Instance& instance) const override;
+};
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include <string>
+#include <sstream>
+#include <stdlib.h>
+#include <cstring>
+
+#include "Util.h"
 
 namespace Util
 {
@@ -25,4 +30,71 @@ namespace Util
 		}
 		return std::string::npos;
 	}
+
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+		auto mix = [&hash](uint64_t word)
+		{
+			word *= 0x87C37B91114253D5ULL;
+			word = (word << 31) | (word >> 33);
+			hash ^= word * 0x4CF5AD432745937FULL;
+			hash = ((hash << 27) | (hash >> 37)) * 5U + 0x52DCE729U;
+		};
+
+		size_t i = 0U;
+		for (; i + 8U <= size; i += 8U)
+		{
+			uint64_t word;
+			memcpy(&word, bytes + i, 8U);
+			mix(word);
+		}
+		uint64_t tail = 0U;
+		for (size_t shift = 0U; i < size; i++, shift += 8U)
+		{
+			tail |= static_cast<uint64_t>(bytes[i]) << shift;
+		}
+		mix(tail);
+
+		// Final avalanche (SplitMix64)
+		hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+		return hash ^ (hash >> 31);
+	}
+
+	std::string FormatDuration(int ms)
+	{
+		int minutes = ms / 1000 / 60;
+		int seconds = (ms % (1000 * 60)) / 1000;
+		int milliseconds = ms % 1000;
+
+		std::ostringstream stringStream;
+		stringStream << minutes << ":" << (seconds < 10 ? "0" : "") << seconds << ".";
+		stringStream << (milliseconds < 100 ? (milliseconds < 10 ? "00" : "0") : "") << milliseconds;
+		return stringStream.str();
+	}
+
+	void* AlignedAlloc(size_t alignment, size_t size)
+	{
+#ifdef _WIN32
+		return _aligned_malloc(size, alignment);
+#else
+		void* ptr = nullptr;
+		if (posix_memalign(&ptr, alignment, size) != 0)
+		{
+			return nullptr;
+		}
+		return ptr;
+#endif
+	}
+
+	void AlignedFree(void* ptr)
+	{
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
 }
@@ -1,11 +1,32 @@
 #pragma once
 #include <string>
+#include <cstdint>
 
 namespace Util
 {
+	const size_t sCacheLineSize = 64U;
+
 	bool StartsWith(const std::string& original, const std::string& value);
 	size_t FindNextNonWhitespace(const std::string& original, size_t offset = 0U);
 
+	// Fast 64-bit hash of a byte range, used to detect changed or corrupt files (not cryptographic)
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0U);
+
+	// Formats milliseconds as mm:ss.ms
+	std::string FormatDuration(int ms);
+
+	// Allocates memory aligned to the given boundary, must be released with AlignedFree
+	void* AlignedAlloc(size_t alignment, size_t size);
+	void AlignedFree(void* ptr);
+
+	// Rounds count up so that count elements of T fill whole cache lines
+	template<typename T>
+	size_t PadToCacheLine(size_t count)
+	{
+		const size_t perLine = sCacheLineSize / sizeof(T);
+		return ((count + perLine - 1U) / perLine) * perLine;
+	}
+
 	template<typename T>
 	T Clamp(T value, T min, T max)
 	{